@@ -1,10 +1,16 @@
 #pragma once
 
 #include "figure_struct.hpp"
+#include "job_system.hpp"
+#include "vertex_format.hpp"
 
 // #include <iosfwd>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace my_engine
 {
@@ -34,10 +40,70 @@ enum class event
 
 std::ostream& operator<<(std::ostream& stream, const event e);
 
+/// render counters collected during one frame
+struct frame_stats
+{
+    /// glDraw* calls issued
+    size_t draw_calls = 0;
+    /// triangles sent to GPU
+    size_t triangles = 0;
+    /// glValidateProgram calls, must be 0 with validation_policy::never
+    size_t program_validations = 0;
+    /// vertex layouts specified, only when vertex array object is built
+    size_t attribute_specifications = 0;
+    /// redundant binds and glEnable calls skipped by state cache
+    size_t elided_state_calls = 0;
+    /// jobs of job_system::run_on_main run in swap_buffers
+    size_t main_jobs = 0;
+    /// meshes of load_mesh_async put into GPU buffers
+    size_t meshes_uploaded = 0;
+    /// use_program calls which waited for driver to finish program
+    size_t program_waits = 0;
+    /// set_uniform calls which found same value in program
+    size_t uniform_uploads_skipped = 0;
+};
+
+/// when engine checks shader program with glValidateProgram
+enum class validation_policy
+{
+    /// before every draw call, synchronous driver round trip each time
+    every_draw,
+    /// once per program and vertex array object pair, result is cached
+    first_use,
+    /// never, default for release builds (NDEBUG)
+    never
+};
+
+/// geometry loaded into GPU memory by engine::load_mesh
+using mesh_handle = uint32_t;
+
+constexpr mesh_handle invalid_mesh = 0;
+
+/// shader program made by engine::create_program
+using program_handle = uint32_t;
+
+/// engine default program (shader/test2.vert, shader/test2.frag with
+/// VERTEX_COLOR)
+constexpr program_handle invalid_program = 0;
+
 class engine;
 
+/// thread which calls GL
+enum class render_mode
+{
+    /// thread which calls engine methods
+    same_thread,
+    /// render thread owning GL context replays commands recorded by engine
+    /// methods, swap_buffers hands frame off, so game logic of next frame
+    /// runs while previous one renders
+    /// load_mesh returns handle at once, read errors are thrown by one of
+    /// next swap_buffers, reload_changed_meshes returns meshes reloaded by
+    /// previous calls
+    render_thread
+};
+
 /// return not null on success
-engine* create_engine();
+engine* create_engine(render_mode mode = render_mode::same_thread);
 void    destroy_engine(engine* e);
 
 class engine
@@ -51,7 +117,83 @@ public:
     /// return true if more events in queue
     virtual bool read_input(event& e)             = 0;
     virtual void render_triangle(const triangle&) = 0;
+    /// quad vertexes go around perimeter, drawn as two indexed triangles
+    virtual void render_quad(const quad&)         = 0;
+    /// load triangles file into GPU buffer, file is read only once
+    /// *.mesh files are binary (mesh_convert), others are text converted
+    /// to format on load, binary files keep their own format
+    /// throw std::runtime_error if file can't be read
+    virtual mesh_handle load_mesh(
+        std::string_view path,
+        vertex_format    format = vertex_format::full) = 0;
+    /// same as load_mesh, but return handle at once, file is read and
+    /// parsed on worker and uploaded by swap_buffers within time budget,
+    /// draws skip mesh until then, after failed read or upload draws
+    /// throw std::runtime_error with its error until
+    /// reload_changed_meshes loads changed file
+    virtual mesh_handle load_mesh_async(
+        std::string_view path,
+        vertex_format    format = vertex_format::full) = 0;
+    virtual void        render_mesh(mesh_handle)         = 0;
+    /// draw all meshes packed in shared buffers with one multi draw indirect
+    /// call per vertex format, draw commands are rebuilt only when list
+    /// or any listed mesh changes, ES contexts use CPU loop of draws
+    virtual void render_meshes(const std::vector<mesh_handle>& visible) = 0;
+    /// draw count copies of mesh with one instanced draw call
+    virtual void render_instanced(mesh_handle          mesh,
+                                  const instance_data* instances,
+                                  size_t               count) = 0;
+    /// queue mesh drawn with current program at placement, queued meshes
+    /// are sorted by program, material, mesh and front to back by clip
+    /// depth of placement origin (view_projection set at call), then
+    /// drawn on swap_buffers
+    /// material - any caller id, equal ones are drawn together
+    virtual void queue_mesh(mesh_handle          mesh,
+                            const instance_data& placement,
+                            uint16_t             material = 0) = 0;
+    /// reload meshes which files modification time changed, failed
+    /// load_mesh_async meshes are read again
+    /// return number of reloaded meshes
+    virtual size_t reload_changed_meshes() = 0;
+    /// drop all not flushed triangles and start new batch
+    virtual void begin_batch()                    = 0;
+    /// add triangle to batch of current shader program
+    virtual void submit(const triangle&)          = 0;
+    /// draw every batch with one draw call per shader program
+    virtual void flush()                          = 0;
+    /// flush batches, draw queued meshes and present frame
     virtual void swap_buffers()                   = 0;
+    /// counters of last presented frame
+    virtual frame_stats last_frame_stats() const  = 0;
+    virtual void set_validation_policy(validation_policy) = 0;
+    /// start compile and link of program from files and return at once,
+    /// all created programs compile in parallel if driver supports
+    /// GL_KHR_parallel_shader_compile
+    /// #include "file" is resolved, defines (NAME or NAME=VALUE) select
+    /// variant, each variant is built once and shared
+    /// throw std::runtime_error if file can't be read
+    virtual program_handle create_program(
+        std::string_view                vertex_path,
+        std::string_view                fragment_path,
+        const std::vector<std::string>& defines = {}) = 0;
+    /// next draws and submits use program, waits only if driver is not done
+    /// with it yet, invalid_program - default program
+    virtual void use_program(program_handle program) = 0;
+    /// column major matrix of frame_data block (shader/frame_data.glsl),
+    /// identity by default, block is uploaded once per frame on first
+    /// draw, so set it before drawing
+    virtual void set_view_projection(const std::array<float, 16>& m) = 0;
+    /// uniform of current program, upload is skipped if program has value
+    /// already, batched and queued draws see value of their draw time
+    virtual void set_uniform(std::string_view name, float value) = 0;
+    virtual void set_uniform(std::string_view            name,
+                             const std::array<float, 4>& value) = 0;
+    virtual void set_uniform(std::string_view             name,
+                             const std::array<float, 16>& value) = 0;
+    /// workers for loading, transforming, culling and sorting
+    /// main jobs run on GL thread in swap_buffers, so they may call GL,
+    /// but not engine methods
+    virtual job_system& jobs() = 0;
     virtual void uninitialize()                   = 0;
 };
 
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "figure_struct.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace my_engine
+{
+
+/// bad token or incomplete record in text geometry file
+/// line and column start from 1
+class parse_error : public std::runtime_error
+{
+public:
+    parse_error(const std::string& message, size_t line, size_t column);
+
+    size_t line   = 0;
+    size_t column = 0;
+};
+
+/// record size in vertexes
+enum class figure_kind
+{
+    vertex   = 1,
+    triangle = 3,
+    quad     = 4
+};
+
+/// parse whitespace separated "x y z r g b" vertexes with std::from_chars
+/// appends to out, vertexes count must be multiple of record size
+/// throw parse_error
+void parse_figures(std::string_view     text,
+                   figure_kind          kind,
+                   std::vector<vertex>& out);
+
+/// map file into memory and parse it, same format as operator>>
+/// throw std::runtime_error if file can't be read, parse_error on bad data
+std::vector<vertex> load_figures(const std::string& path, figure_kind kind);
+
+} // namespace my_engine
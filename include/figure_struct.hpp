@@ -39,6 +39,22 @@ struct quad
     vertex v[4];
 };
 
+/// per instance data of engine::render_instanced
+struct instance_data
+{
+    /// added to scaled mesh position
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+    float scale = 1.f;
+
+    /// multiplied with vertex color
+    float r = 1.f;
+    float g = 1.f;
+    float b = 1.f;
+    float a = 1.f;
+};
+
 std::istream& operator>>(std::istream& is, vertex&);
 std::istream& operator>>(std::istream& is, triangle&);
 std::istream& operator>>(std::istream& is, quad&);
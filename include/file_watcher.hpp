@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace my_engine
+{
+
+/// changed file and its new text, read on watcher thread
+struct file_change
+{
+    std::string path;
+    std::string text;
+};
+
+/// background thread watching files of one directory, not recursive
+/// inotify on Linux (IN_CLOSE_WRITE and IN_MOVED_TO, so editors which
+/// save through temp file and rename are seen), elsewhere modification
+/// times are polled
+/// changed files are read on watcher thread, owner takes them with
+/// take_changes, usually once per frame
+class file_watcher
+{
+public:
+    file_watcher() = default;
+    file_watcher(const file_watcher&) = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+    ~file_watcher();
+
+    /// false and error printed if directory can't be watched
+    bool start(const std::string& directory);
+    void stop();
+    bool running() const { return worker.joinable(); }
+
+    /// changes since previous call, several changes of one file are
+    /// merged into last one, path is directory/name lexically normal
+    std::vector<file_change> take_changes();
+
+private:
+    void loop();
+    void read_changed(const std::filesystem::path& path);
+
+    std::string       directory;
+    std::thread       worker;
+    std::atomic<bool> stopping{ false };
+#ifdef __linux__
+    int notify_fd = -1;
+#endif
+
+    std::mutex               mutex;
+    std::vector<file_change> changes;
+};
+
+} // namespace my_engine
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace my_engine
+{
+
+/// shadow copy of bound GL objects and enabled caps
+/// every bind goes through it, calls which change nothing are skipped
+/// GL_ELEMENT_ARRAY_BUFFER is vertex array state, so it is forgotten
+/// on every vertex array change
+class gl_state_cache
+{
+public:
+    void use_program(GLuint program);
+    void bind_vertex_array(GLuint vao);
+    void bind_buffer(GLenum target, GLuint buffer);
+    /// glBindBufferRange, indexed binding is not shadowed, generic binding
+    /// of target which it changes too is
+    void bind_buffer_range(GLenum     target,
+                           GLuint     index,
+                           GLuint     buffer,
+                           GLintptr   offset,
+                           GLsizeiptr size);
+    void enable(GLenum cap);
+    void disable(GLenum cap);
+
+    /// glDelete* unbinds deleted object, call after it
+    void deleted_buffer(GLuint buffer);
+    void deleted_vertex_array(GLuint vao);
+    void deleted_program(GLuint program);
+
+    /// forget everything, next calls go to GL
+    void invalidate();
+
+    /// calls skipped since previous call
+    size_t take_elided_calls();
+
+private:
+    static constexpr GLuint unknown = ~GLuint(0);
+
+    static constexpr std::array<GLenum, 7> buffer_targets{
+        { GL_ARRAY_BUFFER,
+          GL_ELEMENT_ARRAY_BUFFER,
+          GL_COPY_READ_BUFFER,
+          GL_COPY_WRITE_BUFFER,
+          GL_DRAW_INDIRECT_BUFFER,
+          GL_UNIFORM_BUFFER,
+          GL_PIXEL_UNPACK_BUFFER }
+    };
+
+    static size_t target_index(GLenum target);
+    void          set_cap(GLenum cap, bool value);
+
+    GLuint                                       program      = unknown;
+    GLuint                                       vertex_array = unknown;
+    std::array<GLuint, buffer_targets.size()>    buffers      = make_unknown();
+    std::vector<std::pair<GLenum, bool>>         caps;
+    size_t                                       elided       = 0;
+
+    static std::array<GLuint, buffer_targets.size()> make_unknown()
+    {
+        std::array<GLuint, buffer_targets.size()> result;
+        result.fill(unknown);
+        return result;
+    }
+};
+
+} // namespace my_engine
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "figure_loader.hpp"
+#include "figure_struct.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace my_engine
+{
+
+/// triangle list where every 3 indexes reference shared vertexes
+struct indexed_mesh
+{
+    std::vector<vertex>   vertexes;
+    std::vector<uint32_t> indexes;
+};
+
+/// quad vertexes go around perimeter, drawn as fan of two triangles
+constexpr uint32_t quad_indexes[6] = { 0, 1, 2, 0, 2, 3 };
+
+/// merge bitwise identical vertexes of triangle or quad records
+/// kind == figure_kind::vertex is treated as triangle list
+indexed_mesh weld(const std::vector<vertex>& vertexes, figure_kind kind);
+
+/// 2 if every index fits GL_UNSIGNED_SHORT, else 4
+size_t index_size(const indexed_mesh& m);
+
+/// indexes narrowed to 16 bit, valid only if index_size(m) == 2
+std::vector<uint16_t> indexes_16(const indexed_mesh& m);
+
+} // namespace my_engine
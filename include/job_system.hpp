@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_engine
+{
+
+class job_system;
+
+/// number of unfinished jobs, jobs may wait for it to reach zero
+/// must outlive jobs counted by it, destroy it only after
+/// job_system::wait returned
+class job_counter
+{
+public:
+    job_counter() = default;
+    job_counter(const job_counter&) = delete;
+    job_counter& operator=(const job_counter&) = delete;
+
+    bool done() const { return count.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class job_system;
+
+    struct continuation
+    {
+        std::function<void()> fn;
+        job_counter*          counter = nullptr;
+        bool                  on_main = false;
+    };
+
+    std::atomic<size_t>       count{ 0 };
+    mutable std::mutex        mutex;
+    std::vector<continuation> continuations;
+};
+
+/// fixed set of worker threads, each with own deque of jobs
+/// worker takes newest job of own deque and steals oldest job of other
+/// deques when own is empty, jobs spawned by worker go to its own deque
+/// main queue is for jobs which need GL context, it runs only in
+/// pump_main on GL thread (engine calls it in swap_buffers)
+/// exception of job is printed to std::cerr, counter is still decremented
+class job_system
+{
+public:
+    using job = std::function<void()>;
+
+    job_system() = default;
+    job_system(const job_system&) = delete;
+    job_system& operator=(const job_system&) = delete;
+    ~job_system();
+
+    /// workers == 0 - one less than hardware threads, at least one
+    void   initialize(size_t workers = 0);
+    /// finish all queued worker jobs and join workers
+    void   uninitialize();
+    size_t worker_count() const { return workers.size(); }
+
+    /// counter, if any, is incremented now and decremented after job
+    void run(job j, job_counter* counter = nullptr);
+    void run_on_main(job j, job_counter* counter = nullptr);
+    /// run job (on worker or main) once dependency reaches zero
+    void run_after(job_counter& dependency,
+                   job          j,
+                   job_counter* counter = nullptr,
+                   bool         on_main = false);
+
+    /// call body(begin, end) for chunks of [0, count) on all workers,
+    /// calling thread helps, return when all chunks are done
+    void parallel_for(size_t                                    count,
+                      size_t                                    chunk,
+                      const std::function<void(size_t, size_t)>& body);
+
+    /// run other jobs until counter reaches zero, on GL thread (last
+    /// caller of pump_main) main jobs are run too
+    void wait(const job_counter& counter);
+
+    /// run jobs queued for main thread, no new job starts after budget is
+    /// spent, but at least one runs, return number of jobs run
+    size_t pump_main(std::chrono::steady_clock::duration budget =
+                         std::chrono::steady_clock::duration::max());
+
+private:
+    struct entry
+    {
+        job          fn;
+        job_counter* counter = nullptr;
+    };
+
+    struct worker_queue
+    {
+        std::mutex        mutex;
+        std::deque<entry> jobs;
+    };
+
+    void worker_loop(size_t index);
+    /// own deque from back, then other deques from front
+    bool take(size_t index, entry& e);
+    bool take_main(entry& e);
+    void push(entry e);
+    void execute(entry& e);
+    void finish(job_counter* counter);
+    /// size_t(-1) for threads which are not workers of this system
+    size_t current_worker() const;
+
+    std::vector<std::thread>                   workers;
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::atomic<size_t>                        queued{ 0 };
+    std::atomic<size_t>                        next_queue{ 0 };
+
+    std::mutex              sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t>     sleeping{ 0 };
+    bool                    stopping = false;
+
+    std::mutex                   main_mutex;
+    std::deque<entry>            main_jobs;
+    std::atomic<std::thread::id> main_thread{ std::thread::id() };
+};
+
+} // namespace my_engine
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace my_engine
+{
+
+/// read only view of whole file
+/// mmap on POSIX systems, plain read into memory elsewhere
+/// mapping is prefaulted in constructor, so construct it on loading thread
+class mapped_file
+{
+public:
+    /// throw std::runtime_error if file can't be opened or mapped
+    explicit mapped_file(const std::string& path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    const char*      data() const { return ptr; }
+    size_t           size() const { return length; }
+    std::string_view view() const { return { ptr, length }; }
+
+private:
+    const char* ptr    = nullptr;
+    size_t      length = 0;
+#ifdef _WIN32
+    std::string buffer;
+#endif
+};
+
+} // namespace my_engine
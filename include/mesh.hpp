@@ -0,0 +1,122 @@
+#pragma once
+
+#include "engine.hpp"
+#include "figure_struct.hpp"
+#include "gl_state.hpp"
+#include "glad/glad.h"
+#include "mapped_file.hpp"
+#include "vertex_format.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace my_engine
+{
+
+/// geometry uploaded to GPU once and drawn by handle
+struct mesh
+{
+    std::string                     path;
+    std::filesystem::file_time_type write_time;
+    GLuint                          vbo          = 0;
+    GLsizei                         vertex_count = 0;
+    vertex_format                   format       = vertex_format::full;
+    /// ibo == 0 - not indexed, drawn with glDrawArrays
+    GLuint  ibo         = 0;
+    GLsizei index_count = 0;
+    GLenum  index_type  = GL_UNSIGNED_SHORT;
+    /// built on upload with vbo, ibo and layout of format
+    GLuint vao = 0;
+    /// same plus instance_data attributes, built on first instanced draw
+    GLuint instanced_vao = 0;
+    /// incremented on every upload, copies of mesh data compare it
+    /// 0 - reserved, not uploaded yet
+    uint32_t version = 0;
+    /// why first load failed, write_time is file time at failure then
+    /// cleared by successful upload
+    std::string error;
+};
+
+/// file read and parsed into memory, not yet uploaded to GPU
+/// made on any thread, then uploaded on GL thread
+struct mesh_data
+{
+    std::filesystem::file_time_type write_time;
+    vertex_format                   format       = vertex_format::full;
+    const void*                     vertexes     = nullptr;
+    size_t                          vertex_count = 0;
+    /// index_count == 0 - not indexed
+    const void* indexes     = nullptr;
+    size_t      index_count = 0;
+    size_t      index_size  = sizeof(uint16_t);
+
+    /// owners of memory pointed to above, mapped binary file or
+    /// converted text file
+    std::unique_ptr<mapped_file> file;
+    std::vector<unsigned char>   vertex_storage;
+    std::vector<unsigned char>   index_storage;
+};
+
+/// *.mesh - binary file mapped as is, keeps own format
+/// other  - text triangles file, identical vertexes are welded and
+///          reordered for post transform cache, converted to format
+/// touches no GL, safe on any thread
+/// throw std::runtime_error if file can't be read, is empty or any record
+/// is bad or incomplete, so reload never uploads half written file
+mesh_data read_mesh_data(const std::string& path, vertex_format format);
+
+/// owns all meshes, handle is index in storage plus one
+/// every method may change GL_ARRAY_BUFFER and vertex array bindings,
+/// all of them go through state cache given on initialize
+class mesh_cache
+{
+public:
+    /// attribute_binding - use glVertexAttribFormat/glBindVertexBuffer
+    /// state must outlive cache
+    void initialize(bool attribute_binding, gl_state_cache& state);
+    /// load file once, next calls with same path return same handle
+    /// text files are converted to format, binary ones keep own format
+    /// throw std::runtime_error if file can't be read
+    mesh_handle load(std::string_view path, vertex_format format);
+    /// handle for path without reading file, created is true if path was
+    /// not known, mesh is pending until upload
+    mesh_handle reserve(std::string_view path,
+                        vertex_format    format,
+                        bool&            created);
+    /// put data read by read_mesh_data into mesh buffers
+    void upload(mesh_handle handle, const mesh_data& data);
+    /// first load of reserved mesh failed, reload_changed retries it when
+    /// file time changes
+    void fail(mesh_handle handle, const std::string& error);
+    /// nullptr for invalid, pending or failed handle
+    const mesh* find(mesh_handle handle) const;
+    /// reserved, not uploaded yet and not failed
+    bool pending(mesh_handle handle) const;
+    /// error of failed handle, nullptr if handle is not failed
+    const std::string* failure(mesh_handle handle) const;
+    /// vertex array object with instance_data attributes (divisor 1)
+    /// with attribute binding they read binding 1, which caller points to
+    /// instance data with glBindVertexBuffer before every draw
+    GLuint instanced_vao(mesh_handle handle);
+    /// upload again meshes with changed file modification time, failed
+    /// meshes are loaded again too, pending ones are left to their upload
+    /// return number of reloaded meshes
+    size_t reload_changed();
+    void   clear();
+    /// vertex layouts specified since previous call
+    size_t take_attribute_specifications();
+
+private:
+    /// upload data into buffers inside mesh vertex array object
+    void upload_mesh(mesh& m, const mesh_data& data);
+
+    std::vector<mesh> meshes;
+    gl_state_cache*   state                    = nullptr;
+    bool              attribute_binding        = false;
+    size_t            attribute_specifications = 0;
+};
+
+} // namespace my_engine
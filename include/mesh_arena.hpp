@@ -0,0 +1,117 @@
+#pragma once
+
+#include "engine.hpp"
+#include "gl_state.hpp"
+#include "glad/glad.h"
+#include "mesh.hpp"
+#include "vertex_format.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace my_engine
+{
+
+/// layout of glMultiDrawElementsIndirect command
+struct draw_elements_command
+{
+    GLuint count          = 0;
+    GLuint instance_count = 1;
+    GLuint first_index    = 0;
+    GLint  base_vertex    = 0;
+    GLuint base_instance  = 0;
+};
+
+/// place of mesh inside arena buffers
+struct arena_range
+{
+    GLuint   vertex_count = 0;
+    GLuint   index_count  = 0;
+    GLuint   first_index  = 0;
+    GLint    base_vertex  = 0;
+    uint32_t mesh_version = 0;
+};
+
+/// indexed meshes of one vertex format and index type packed into shared
+/// vertex and index buffers, so all of them draw with one vertex array
+/// object and one glMultiDrawElementsIndirect call
+/// meshes are copied GPU to GPU with glCopyBufferSubData, arena grows by
+/// doubling, space of reloaded and removed meshes is kept in free lists
+/// and reused first fit
+class mesh_arena
+{
+public:
+    /// state must outlive arena
+    void initialize(vertex_format   format,
+                    GLenum          index_type,
+                    bool            attribute_binding,
+                    bool            indirect,
+                    gl_state_cache& state);
+    void uninitialize();
+
+    vertex_format format() const { return format_; }
+    GLenum        index_type() const { return index_type_; }
+    GLuint        vao() const { return vao_; }
+
+    /// copy mesh into arena if missing or older than m.version
+    /// leaves arena vertex array object bound
+    const arena_range& place(mesh_handle handle, const mesh& m);
+    /// free space of mesh, for mesh moved to other arena, no-op if missing
+    void remove(mesh_handle handle);
+
+    /// commands drawn by draw(), uploaded to indirect buffer here
+    void set_commands(std::vector<draw_elements_command> commands);
+    bool empty() const { return commands.empty(); }
+
+    /// bind vertex array and draw all commands with one
+    /// glMultiDrawElementsIndirect or CPU loop of glDrawElementsBaseVertex
+    void draw(frame_stats& stats) const;
+
+private:
+    /// unused bytes inside used part of buffer
+    struct free_block
+    {
+        size_t offset = 0;
+        size_t size   = 0;
+    };
+
+    /// first fit block of free, or end of used part which grows
+    static size_t allocate(std::vector<free_block>& free,
+                           size_t&                  used,
+                           size_t                   size);
+    /// merge with neighbour blocks, block at end shrinks used instead
+    static void release(std::vector<free_block>& free,
+                        size_t&                  used,
+                        size_t                   offset,
+                        size_t                   size);
+    void        release(const arena_range& range);
+
+    /// grow buffer of target to hold at least capacity bytes
+    void reserve(GLuint& buffer, size_t& capacity, size_t used, size_t need);
+    void bind_buffers();
+
+    vertex_format format_     = vertex_format::full;
+    GLenum        index_type_ = GL_UNSIGNED_INT;
+    bool          attribute_binding = false;
+    bool          indirect          = false;
+    gl_state_cache* state           = nullptr;
+
+    GLuint vao_          = 0;
+    GLuint vbo           = 0;
+    GLuint ibo           = 0;
+    GLuint indirect_buffer = 0;
+
+    size_t vertex_capacity = 0;
+    size_t vertex_used     = 0;
+    size_t index_capacity  = 0;
+    size_t index_used      = 0;
+
+    /// sorted by offset
+    std::vector<free_block> free_vertexes;
+    std::vector<free_block> free_indexes;
+
+    std::unordered_map<mesh_handle, arena_range> ranges;
+    std::vector<draw_elements_command>           commands;
+};
+
+} // namespace my_engine
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "vertex_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace my_engine
+{
+
+/// binary mesh file, little endian
+/// [mesh_file_header][padding][vertex blob][padding][index blob]
+/// blobs start at offsets aligned to mesh_blob_alignment, so mapped file
+/// memory can go straight into glBufferData/glBufferSubData
+constexpr uint32_t mesh_file_magic     = 0x4853454d; // "MESH"
+constexpr uint32_t mesh_file_version   = 1;
+constexpr size_t   mesh_blob_alignment = 256;
+constexpr size_t   mesh_max_attributes = 8;
+
+/// one vertex attribute, same meaning as glVertexAttribPointer arguments
+struct mesh_attribute_desc
+{
+    uint32_t location   = 0;
+    uint32_t type       = 0; // GL_FLOAT, GL_HALF_FLOAT, ...
+    uint32_t count      = 0;
+    uint32_t normalized = 0;
+    uint32_t offset     = 0;
+};
+
+struct mesh_file_header
+{
+    uint32_t            magic           = mesh_file_magic;
+    uint32_t            version         = mesh_file_version;
+    uint32_t            vertex_stride   = 0;
+    uint32_t            attribute_count = 0;
+    mesh_attribute_desc attributes[mesh_max_attributes];
+    uint64_t            vertex_count  = 0;
+    uint64_t            vertex_offset = 0;
+    /// bytes per index: 0 - not indexed, 2 or 4
+    uint32_t index_size   = 0;
+    uint32_t reserved     = 0;
+    uint64_t index_count  = 0;
+    uint64_t index_offset = 0;
+};
+
+static_assert(sizeof(mesh_file_header) == 216, "mesh file header layout");
+
+/// pointers into mapped file, valid while file is mapped
+struct mesh_file_view
+{
+    const mesh_file_header* header   = nullptr;
+    const void*             vertexes = nullptr;
+    const void*             indexes  = nullptr;
+};
+
+/// header describing vertex layout of format, counts are zero
+mesh_file_header mesh_header(vertex_format format);
+
+/// check magic, version and blob ranges (inside file, after header,
+/// aligned, at most INT32_MAX elements), no data is copied
+/// throw std::runtime_error
+mesh_file_view read_mesh_file(const mapped_file& file);
+
+/// write file, offsets in header are computed here
+/// throw std::runtime_error
+void write_mesh_file(const std::string& path,
+                     mesh_file_header   header,
+                     const void*        vertexes,
+                     const void*        indexes);
+
+/// true if both headers describe same vertex attributes
+bool same_vertex_layout(const mesh_file_header& a, const mesh_file_header& b);
+
+} // namespace my_engine
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "indexed_mesh.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace my_engine
+{
+
+/// post transform cache size used for ACMR, typical for desktop GPUs
+constexpr size_t default_vertex_cache_size = 16;
+
+/// average cache miss ratio: transformed vertexes per triangle with FIFO
+/// post transform cache, 0.5 is ideal for big grids, 3.0 is worst case
+float compute_acmr(const std::vector<uint32_t>& indexes,
+                   size_t                       vertex_count,
+                   size_t cache_size = default_vertex_cache_size);
+
+/// reorder triangles for post transform cache reuse
+/// Tom Forsyth "Linear-Speed Vertex Cache Optimisation"
+void optimize_vertex_cache(std::vector<uint32_t>& indexes,
+                           size_t                 vertex_count);
+
+/// reorder vertexes in order of first use by indexes, so vertex fetch
+/// reads memory mostly sequentially, unused vertexes are dropped
+void optimize_vertex_fetch(indexed_mesh& m);
+
+/// both passes above, return ACMR before and after
+struct acmr_report
+{
+    float before = 0.f;
+    float after  = 0.f;
+};
+acmr_report optimize(indexed_mesh& m);
+
+} // namespace my_engine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+namespace my_engine
+{
+
+/// linked programs saved on disk with glGetProgramBinary and restored
+/// with glProgramBinary (GL 4.1, ES 3.0)
+/// key is FNV-1a hash of shader sources and GL vendor, renderer and
+/// version strings, so driver update or other GPU miss the cache
+/// binary rejected by driver is rebuilt from sources and saved again
+class program_cache
+{
+public:
+    /// directory is created if missing
+    /// cache is disabled without binary formats, then every load misses
+    void initialize(const std::string& directory);
+    bool enabled() const { return enabled_; }
+
+    uint64_t key(std::initializer_list<std::string_view> sources) const;
+    /// linked program or 0 if cache has no valid binary for key
+    GLuint load(uint64_t key);
+    /// save binary of linked program, link it with
+    /// GL_PROGRAM_BINARY_RETRIEVABLE_HINT, build_time - time of compile
+    /// and link, used to report time saved by next load
+    void store(uint64_t                  key,
+               GLuint                    program,
+               std::chrono::microseconds build_time);
+
+    /// build time of cache hits minus time spent loading them
+    std::chrono::microseconds time_saved() const { return saved; }
+
+private:
+    std::string file_name(uint64_t key) const;
+
+    std::string               directory;
+    std::string               driver;
+    bool                      enabled_ = false;
+    std::chrono::microseconds saved{ 0 };
+};
+
+} // namespace my_engine
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "engine.hpp"
+#include "figure_struct.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace my_engine
+{
+
+/// one draw collected during frame, executed in key order on swap_buffers
+struct draw_packet
+{
+    uint32_t      program  = 0;
+    uint16_t      material = 0;
+    mesh_handle   mesh     = invalid_mesh;
+    instance_data placement;
+};
+
+/// bits from high to low: program 12, material 16, mesh 16, depth 20
+/// sorted packets change program least often and mesh most often,
+/// depth only orders packets with equal state, nearer (lower) goes first
+/// depth is clip space z / w, clamped to [-1, 1]
+/// only low bits of each field are kept: programs above 4095 and meshes
+/// above 65535 share key with lower ids, then only depth orders them
+uint64_t make_sort_key(uint32_t    program,
+                       uint16_t    material,
+                       mesh_handle mesh,
+                       float       depth);
+
+struct sort_entry
+{
+    uint64_t key    = 0;
+    uint32_t packet = 0;
+};
+
+/// stable least significant digit radix sort by 8 bit digits,
+/// passes where every key has same digit are skipped
+/// scratch is resized to entries size and may be reused between calls
+void radix_sort(std::vector<sort_entry>& entries,
+                std::vector<sort_entry>& scratch);
+
+/// packets of one frame, sorted once before execution
+class render_queue
+{
+public:
+    void push(const draw_packet& packet, float depth);
+    void sort();
+    void clear();
+
+    size_t size() const { return entries.size(); }
+    bool   empty() const { return entries.empty(); }
+    /// packet number i in key order, valid after sort until clear
+    const draw_packet& operator[](size_t i) const
+    {
+        return packets[entries[i].packet];
+    }
+
+private:
+    std::vector<draw_packet> packets;
+    std::vector<sort_entry>  entries;
+    std::vector<sort_entry>  scratch;
+};
+
+} // namespace my_engine
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_engine
+{
+
+/// double buffered command list between game thread and render thread
+/// game thread records commands of next frame while render thread replays
+/// commands of previous one, hand_off swaps lists once per frame
+/// exception of command is kept and rethrown by next hand_off
+class render_thread
+{
+public:
+    using command = std::function<void()>;
+
+    render_thread() = default;
+    render_thread(const render_thread&) = delete;
+    render_thread& operator=(const render_thread&) = delete;
+    ~render_thread();
+
+    /// on_start runs first on new thread, on_stop last before it exits,
+    /// they are place to make GL context current and release it
+    void start(command on_start, command on_stop);
+    /// game thread only
+    void record(command c);
+    /// give recorded commands to render thread, wait while it still
+    /// replays previous list
+    /// throw first exception of commands replayed since previous call,
+    /// recorded commands are handed off anyway
+    void hand_off();
+    /// replay handed off commands, then join thread
+    /// recorded but not handed off commands are dropped
+    void stop();
+
+private:
+    void loop(const command& on_start, const command& on_stop);
+    void fail(std::exception_ptr error);
+
+    std::thread             worker;
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    std::vector<command> recording;
+    std::vector<command> pending;
+    bool                 has_pending = false;
+    bool                 stopping    = false;
+    bool                 alive       = false;
+    std::exception_ptr   failure;
+};
+
+} // namespace my_engine
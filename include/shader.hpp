@@ -2,8 +2,84 @@
 
 #include "glad/glad.h"
 
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iostream>
 #include <string>
+#include <vector>
+
+namespace my_engine
+{
+class job_system;
+}
+
+/// glGetError checking level
+/// 0 - off, OM_GL_CHECK() is empty
+/// 1 - per frame, OM_GL_CHECK() only records call site into small ring,
+///     OM_GL_CHECK_FRAME() polls glGetError once per frame and prints
+///     last recorded call sites on error
+/// 2 - per call, glGetError after every checked GL call
+#ifndef OM_GL_CHECK_LEVEL
+#ifdef NDEBUG
+#define OM_GL_CHECK_LEVEL 1
+#else
+#define OM_GL_CHECK_LEVEL 2
+#endif
+#endif
+
+struct gl_call_site
+{
+    const char* file     = nullptr;
+    int         line     = 0;
+    const char* function = nullptr;
+};
+
+constexpr size_t gl_call_history_size = 16;
+
+/// last checked GL call sites, used only with OM_GL_CHECK_LEVEL 1
+inline std::array<gl_call_site, gl_call_history_size> gl_call_history{};
+inline size_t                                          gl_call_history_next = 0;
+
+inline void gl_record_call(const char* file, int line, const char* function)
+{
+    gl_call_history[gl_call_history_next % gl_call_history_size] = {
+        file, line, function
+    };
+    ++gl_call_history_next;
+}
+
+/// poll all pending GL errors, print them with recorded call sites
+/// return true if no errors
+bool gl_check_frame();
+
+const char* gl_error_to_str(GLenum err);
+
+#if OM_GL_CHECK_LEVEL == 0
+
+#define OM_GL_CHECK()
+#define OM_GL_CHECK_FRAME()
+
+#elif OM_GL_CHECK_LEVEL == 1
+
+#define OM_GL_CHECK()                                                          \
+    {                                                                          \
+        gl_record_call(__FILE__, __LINE__, __FUNCTION__);                      \
+    }
+
+#define OM_GL_CHECK_FRAME()                                                    \
+    {                                                                          \
+        if (!gl_check_frame())                                                 \
+        {                                                                      \
+            assert(false);                                                     \
+        }                                                                      \
+    }
+
+#else
+
+#define OM_GL_CHECK_FRAME()
 
 #define OM_GL_CHECK()                                                          \
     {                                                                          \
@@ -35,14 +111,56 @@
         }                                                                      \
     }
 
+#endif
+
 void shader_loadFile(const std::string& path,
                      const std::string& file_name,
                      std::string*       result);
 
+/// read file on worker of jobs, future is ready with text or exception
+std::future<std::string> shader_loadFile_async(my_engine::job_system& jobs,
+                                               const std::string&     path,
+                                               const std::string& file_name);
+
 GLuint shader_create_shader(const std::string path,
                             const std::string file_name,
                             GLuint            type);
 
+/// compile text already read from file
+GLuint shader_compile(const std::string& text, GLuint type);
+
+/// link and delete compiled shaders
+/// retrievable - set GL_PROGRAM_BINARY_RETRIEVABLE_HINT before link
+GLuint shader_link_program(GLuint vert_shader,
+                           GLuint frag_shader,
+                           bool   retrievable = false);
+
+/// start compile or link without status query, which waits for driver
+GLuint shader_compile_start(const std::string& text, GLuint type);
+GLuint shader_link_start(GLuint vert_shader,
+                         GLuint frag_shader,
+                         bool   retrievable = false);
+/// specialization constant of SPIR-V shader, value is bit pattern of
+/// bool, int or float constant
+struct spirv_constant
+{
+    GLuint id    = 0;
+    GLuint value = 0;
+};
+
+/// words of SPIR-V module, throw std::runtime_error if file can't be read
+/// or is not SPIR-V
+std::vector<uint32_t> shader_load_spirv(const std::string& path);
+/// glShaderBinary and glSpecializeShader (GL 4.6) with entry point main,
+/// constants not declared by module are skipped, so one list may serve
+/// both stages
+GLuint shader_spirv_start(const std::vector<uint32_t>&       binary,
+                          GLuint                             type,
+                          const std::vector<spirv_constant>& constants);
+/// query status, waits if not done yet, print log on failure
+bool shader_compile_check(GLuint shader);
+bool shader_link_check(GLuint program);
+
 GLuint shader_create_program(const std::string path,
                              const std::string vertex_file_name,
                              const std::string fragment_file_name);
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "engine.hpp"
+#include "gl_state.hpp"
+#include "glad/glad.h"
+#include "program_cache.hpp"
+#include "shader.hpp"
+#include "shader_preprocessor.hpp"
+#include "uniform_cache.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace my_engine
+{
+
+/// programs compiled and linked without waiting for driver
+/// create starts compile and link and returns at once, so all programs
+/// compile together on driver threads (GL_KHR_parallel_shader_compile or
+/// GL_ARB_parallel_shader_compile), poll finishes programs which are done
+/// without blocking, get waits only for program not done yet
+/// without extension status can't be polled, first get waits
+/// programs from files are preprocessed variants, one per define set,
+/// built once on first use
+/// reload of changed file builds replacement the same way, old program
+/// stays in use until replacement links and poll swaps it in, failed
+/// replacement is dropped
+/// every linked program gets frame_data block at frame_data_binding
+class shader_manager
+{
+public:
+    /// get_proc resolves glMaxShaderCompilerThreadsKHR, cache and state
+    /// must outlive manager
+    void initialize(program_cache&  cache,
+                    gl_state_cache& state,
+                    GLADloadproc    get_proc);
+    bool parallel() const { return parallel_; }
+    /// GL 4.6 context which accepts GL_SHADER_BINARY_FORMAT_SPIR_V
+    bool spirv() const { return spirv_; }
+
+    /// from program cache or compiled from sources, never reloaded
+    program_handle create(const std::string& vertex_source,
+                          const std::string& fragment_source);
+    /// variant of files with defines, same files and define set in any
+    /// order give same handle, reload follows every included file
+    /// throw std::runtime_error if file can't be read
+    program_handle load(const std::string&    vertex_path,
+                        const std::string&    fragment_path,
+                        const shader_defines& defines,
+                        const shader_reader&  read = shader_read_file);
+    /// program of SPIR-V modules built offline, constants specialize them
+    /// instead of defines, never reloaded
+    /// invalid_program without spirv() or if file is missing, then caller
+    /// uses GLSL variant
+    /// throw std::runtime_error if file is not SPIR-V
+    program_handle load_spirv(const std::string&                 vertex_path,
+                              const std::string&                 fragment_path,
+                              const std::vector<spirv_constant>& constants);
+    /// linked program, waits if driver is not done yet
+    /// throw std::runtime_error for invalid handle
+    GLuint get(program_handle handle);
+    /// start rebuild of every variant using file at path, text is new text
+    /// of it, other files are read again, return number of programs rebuilt
+    size_t reload(const std::string& path, const std::string& text);
+    /// finish done programs, store their binaries in cache, swap in linked
+    /// replacements, never waits with parallel compile
+    /// return number of programs swapped, their get value changed
+    size_t poll();
+    /// delete all programs
+    void clear();
+
+    /// number of get calls which had to wait since previous call
+    size_t take_waits();
+
+    /// uniforms of programs of get, values follow reloaded programs
+    uniform_cache& uniforms() { return uniforms_; }
+
+private:
+    struct build
+    {
+        GLuint   program = 0;
+        GLuint   vert    = 0;
+        GLuint   frag    = 0;
+        uint64_t key     = 0;
+        bool     pending = false;
+        /// completion already seen by done
+        bool completed = false;
+
+        std::chrono::steady_clock::time_point start;
+        /// compile and link time stored in cache, frames between start
+        /// and finish are not counted
+        std::chrono::steady_clock::duration elapsed{};
+    };
+
+    struct entry
+    {
+        build current;
+        /// replacement from reload, program is 0 if none
+        build next;
+
+        std::string    vertex_path;
+        std::string    fragment_path;
+        shader_defines defines;
+        /// files of both stages, empty for programs of create
+        std::vector<std::string> files;
+    };
+
+    /// preprocess files of variant into e.files and start build
+    build start(entry& e, const shader_reader& read);
+    /// from cache or started compile and link
+    build start(const std::string& vertex_source,
+                const std::string& fragment_source);
+    /// check status (waits), print logs, store binary, return linked
+    bool finish(build& b);
+    /// GL_COMPLETION_STATUS_KHR, first true result sets b.elapsed
+    bool done(build& b);
+    /// program is usable, bind its uniform blocks
+    void bind_blocks(GLuint program);
+    void discard(build& b);
+
+    program_cache*     cache     = nullptr;
+    gl_state_cache*    state     = nullptr;
+    bool               parallel_ = false;
+    bool               spirv_    = false;
+    std::vector<entry> programs;
+    size_t             waits = 0;
+    uniform_cache      uniforms_;
+    /// paths and define set of variant to its handle
+    std::unordered_map<std::string, program_handle> variants;
+};
+
+} // namespace my_engine
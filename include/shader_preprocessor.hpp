@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace my_engine
+{
+
+/// define set of one shader variant, each item NAME or NAME=VALUE
+using shader_defines = std::vector<std::string>;
+
+/// sorted without duplicates, so one set gives one permutation key in any
+/// order
+shader_defines normal_defines(shader_defines defines);
+
+/// text of file by lexically normal path
+/// throw std::runtime_error if file can't be read
+using shader_reader = std::function<std::string(const std::string& path)>;
+
+/// shader_loadFile with exception of reader
+std::string shader_read_file(const std::string& path);
+
+struct preprocessed_shader
+{
+    std::string text;
+    /// main file first, then every included file, lexically normal
+    /// source string number of #line and compile logs is index here
+    std::vector<std::string> files;
+};
+
+/// #include "name" is replaced by file relative to including one, every
+/// file is included once per #if branch, so guards are not needed and
+/// cycles are cut, file included inside conditional and after its #endif
+/// is included twice and needs guards
+/// defines go right after #version line of main file, #line keeps line
+/// numbers of compile logs
+/// throw std::runtime_error if file can't be read
+preprocessed_shader shader_preprocess(const std::string&    path,
+                                      const shader_defines& defines,
+                                      const shader_reader&  read);
+
+} // namespace my_engine
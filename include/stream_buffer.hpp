@@ -0,0 +1,53 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+
+namespace my_engine
+{
+
+/// triple buffered ring for dynamic vertex data
+/// CPU writes region of current frame while GPU still reads two previous
+/// regions, every region is guarded with fence, so buffer is never orphaned
+/// or reallocated after initialize
+class stream_buffer
+{
+public:
+    static constexpr size_t frames_count = 3;
+
+    /// buffer must be bound to GL_ARRAY_BUFFER before call
+    /// persistent == true  - glBufferStorage + persistent coherent mapping
+    /// persistent == false - glMapBufferRange unsynchronized on every write
+    void initialize(GLuint buffer_id, size_t frame_size, bool persistent);
+    void uninitialize();
+
+    /// copy data into region of current frame
+    /// return offset in bytes from buffer start aligned to alignment
+    /// throw std::runtime_error if region has no space left
+    GLintptr write(const void* data, size_t size, size_t alignment);
+    /// bytes still available in current frame region
+    size_t space_left(size_t alignment) const;
+    /// fence written region and move to next one, wait while GPU still
+    /// reads it, used when region is full in the middle of frame
+    void next_region();
+    /// fence region of finished frame and move to next region
+    void next_frame() { next_region(); }
+
+    GLuint id() const { return buffer; }
+    bool   is_persistent() const { return persistent; }
+
+private:
+    size_t aligned_offset(size_t alignment) const;
+
+    GLuint                           buffer       = 0;
+    unsigned char*                   mapped       = nullptr;
+    size_t                           frame_size   = 0;
+    size_t                           frame_index  = 0;
+    size_t                           frame_offset = 0;
+    std::array<GLsync, frames_count> fences{};
+    bool                             persistent = false;
+};
+
+} // namespace my_engine
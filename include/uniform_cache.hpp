@@ -0,0 +1,96 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace my_engine
+{
+
+/// std140 layout of uniform block frame_data of shader/frame_data.glsl
+struct frame_data
+{
+    /// column major
+    std::array<float, 16> view_projection{ { 1.f, 0.f, 0.f, 0.f, //
+                                             0.f, 1.f, 0.f, 0.f,
+                                             0.f, 0.f, 1.f, 0.f,
+                                             0.f, 0.f, 0.f, 1.f } };
+    /// seconds since engine initialize
+    float time = 0.f;
+    float padding[3]{};
+};
+
+static_assert(sizeof(frame_data) == 80, "frame_data must match std140");
+
+/// uniform buffer binding point of frame_data in every program
+constexpr GLuint frame_data_binding = 0;
+
+/// uniform locations and last values per program
+/// location is looked up once per program and name, missing uniform too,
+/// set skips upload when program already has same value
+class uniform_cache
+{
+public:
+    /// state must outlive cache, setters bind program through it
+    void initialize(gl_state_cache& state);
+
+    /// -1 if program has no active uniform name
+    GLint location(GLuint program, std::string_view name);
+
+    /// false if program has no active uniform name
+    bool set(GLuint program, std::string_view name, GLint value);
+    bool set(GLuint program, std::string_view name, float value);
+    bool set(GLuint                      program,
+             std::string_view            name,
+             const std::array<float, 2>& value);
+    bool set(GLuint                      program,
+             std::string_view            name,
+             const std::array<float, 3>& value);
+    bool set(GLuint                      program,
+             std::string_view            name,
+             const std::array<float, 4>& value);
+    /// mat4, column major
+    bool set(GLuint                       program,
+             std::string_view             name,
+             const std::array<float, 16>& value);
+
+    /// program is rebuilt, values set for old one are uploaded to new one
+    void replace(GLuint old_program, GLuint new_program);
+    /// program is deleted, its name may come back for other program
+    void forget(GLuint program);
+    void clear();
+
+    /// uploads skipped since previous call
+    size_t take_skipped();
+
+private:
+    struct uniform
+    {
+        std::string name;
+        GLint       location = -1;
+        /// of last uploaded value, GL_NONE if nothing uploaded yet
+        GLenum                type = GL_NONE;
+        std::array<float, 16> value{};
+        GLint                 int_value = 0;
+    };
+
+    uniform& find(GLuint program, std::string_view name);
+    bool     set_floats(GLuint           program,
+                        std::string_view name,
+                        GLenum           type,
+                        const float*     value,
+                        size_t           count);
+    void     upload(GLuint program, const uniform& u);
+
+    gl_state_cache*                                  state = nullptr;
+    std::unordered_map<GLuint, std::vector<uniform>> programs;
+    size_t                                           skipped = 0;
+};
+
+} // namespace my_engine
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "figure_struct.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace my_engine
+{
+
+/// layout of vertexes in GPU buffer
+enum class vertex_format
+{
+    /// my_engine::vertex, 24 bytes
+    full,
+    /// vertex_half, 12 bytes
+    half,
+    /// vertex_packed, 8 bytes, positions must be in [-1, 1], see fit_format
+    packed
+};
+
+/// half float position (w = 1) and normalized rgba8 color
+struct vertex_half
+{
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t z = 0;
+    uint16_t w = 0;
+
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+};
+
+/// position in normalized GL_INT_2_10_10_10_REV and normalized rgba8 color
+struct vertex_packed
+{
+    uint32_t position = 0;
+
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+};
+
+static_assert(sizeof(vertex_half) == 12, "vertex_half must be tightly packed");
+static_assert(sizeof(vertex_packed) == 8, "vertex_packed must be tightly packed");
+
+/// bytes per vertex
+size_t vertex_size(vertex_format format);
+
+uint16_t      float_to_half(float value);
+vertex_half   to_half(const vertex& v);
+/// throw std::runtime_error if position is out of [-1, 1]
+vertex_packed to_packed(const vertex& v);
+
+/// format itself, or half for packed if some position is out of [-1, 1],
+/// fallback is printed to std::clog
+vertex_format fit_format(const std::vector<vertex>& vertexes,
+                         vertex_format              format);
+
+/// vertexes converted to format, ready for upload
+std::vector<unsigned char> convert_vertexes(const std::vector<vertex>& vertexes,
+                                            vertex_format              format);
+
+} // namespace my_engine
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "figure_struct.hpp"
+#include "glad/glad.h"
+#include "vertex_format.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace my_engine
+{
+
+/// attribute locations fixed by layout qualifiers in shader/test2.vert
+constexpr GLuint attribute_position        = 0;
+constexpr GLuint attribute_color           = 1;
+constexpr GLuint attribute_instance_offset = 2;
+constexpr GLuint attribute_instance_color  = 3;
+
+/// one vertex attribute, arguments of glVertexAttribPointer/Format
+struct vertex_attribute
+{
+    GLuint    location   = 0;
+    GLint     count      = 0;
+    GLenum    type       = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    GLuint    offset     = 0;
+};
+
+/// describe attribute of member in vertex type V
+#define OM_VERTEX_ATTRIBUTE(V, member, location, count, type, normalized)      \
+    ::my_engine::vertex_attribute                                              \
+    {                                                                          \
+        location, count, type, normalized,                                     \
+            static_cast<GLuint>(offsetof(V, member))                           \
+    }
+
+/// compile time description, specialize for every vertex type
+template <typename V>
+struct vertex_layout;
+
+template <>
+struct vertex_layout<vertex>
+{
+    static constexpr std::array<vertex_attribute, 2> attributes{ {
+        OM_VERTEX_ATTRIBUTE(vertex, x, attribute_position, 3, GL_FLOAT, GL_FALSE),
+        OM_VERTEX_ATTRIBUTE(vertex, r, attribute_color, 3, GL_FLOAT, GL_FALSE),
+    } };
+};
+
+template <>
+struct vertex_layout<vertex_half>
+{
+    static constexpr std::array<vertex_attribute, 2> attributes{ {
+        OM_VERTEX_ATTRIBUTE(
+            vertex_half, x, attribute_position, 4, GL_HALF_FLOAT, GL_FALSE),
+        OM_VERTEX_ATTRIBUTE(
+            vertex_half, r, attribute_color, 4, GL_UNSIGNED_BYTE, GL_TRUE),
+    } };
+};
+
+template <>
+struct vertex_layout<vertex_packed>
+{
+    static constexpr std::array<vertex_attribute, 2> attributes{ {
+        OM_VERTEX_ATTRIBUTE(vertex_packed,
+                            position,
+                            attribute_position,
+                            4,
+                            GL_INT_2_10_10_10_REV,
+                            GL_TRUE),
+        OM_VERTEX_ATTRIBUTE(
+            vertex_packed, r, attribute_color, 4, GL_UNSIGNED_BYTE, GL_TRUE),
+    } };
+};
+
+template <>
+struct vertex_layout<instance_data>
+{
+    static constexpr std::array<vertex_attribute, 2> attributes{ {
+        OM_VERTEX_ATTRIBUTE(instance_data,
+                            x,
+                            attribute_instance_offset,
+                            4,
+                            GL_FLOAT,
+                            GL_FALSE),
+        OM_VERTEX_ATTRIBUTE(
+            instance_data, r, attribute_instance_color, 4, GL_FLOAT, GL_FALSE),
+    } };
+};
+
+/// bytes of one attribute value
+constexpr size_t attribute_size(const vertex_attribute& a)
+{
+    switch (a.type)
+    {
+        case GL_FLOAT:
+            return 4u * static_cast<size_t>(a.count);
+        case GL_HALF_FLOAT:
+            return 2u * static_cast<size_t>(a.count);
+        case GL_UNSIGNED_BYTE:
+            return 1u * static_cast<size_t>(a.count);
+        case GL_INT_2_10_10_10_REV:
+            return 4u;
+    }
+    return 0;
+}
+
+/// every attribute lies inside vertex and has known type
+template <typename V>
+constexpr bool layout_fits()
+{
+    for (const vertex_attribute& a : vertex_layout<V>::attributes)
+    {
+        const size_t size = attribute_size(a);
+        if (size == 0 || a.offset + size > sizeof(V))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(layout_fits<vertex>(), "bad vertex layout");
+static_assert(layout_fits<vertex_half>(), "bad vertex_half layout");
+static_assert(layout_fits<vertex_packed>(), "bad vertex_packed layout");
+static_assert(layout_fits<instance_data>(), "bad instance_data layout");
+
+/// type erased layout, points to static vertex_layout<V>::attributes
+struct vertex_layout_desc
+{
+    GLsizei                 stride     = 0;
+    const vertex_attribute* attributes = nullptr;
+    size_t                  count      = 0;
+};
+
+template <typename V>
+constexpr vertex_layout_desc describe_layout()
+{
+    return { static_cast<GLsizei>(sizeof(V)),
+             vertex_layout<V>::attributes.data(),
+             vertex_layout<V>::attributes.size() };
+}
+
+const vertex_layout_desc& layout_of(vertex_format format);
+
+/// enable attributes and point them into currently bound GL_ARRAY_BUFFER
+/// starting at base offset, divisor != 0 - per instance attributes
+void apply_vertex_layout(const vertex_layout_desc& layout,
+                         GLintptr                  base    = 0,
+                         GLuint                    divisor = 0);
+
+/// separate attribute format (GL 4.3, ES 3.1), attributes read from
+/// buffer bound with glBindVertexBuffer(binding, ...)
+void apply_vertex_format(const vertex_layout_desc& layout, GLuint binding);
+
+} // namespace my_engine
@@ -0,0 +1,11 @@
+// green in front of z = 0, red behind, brighter closer to z = 0
+vec4 depth_color(vec4 position)
+{
+    if (position.z >= 0.0)
+    {
+        float light_green = 0.5 + position.z / 2.0;
+        return vec4(0.0, light_green, 0.0, 1.0);
+    }
+    float color = 0.5 - (position.z / -2.0);
+    return vec4(color, 0.0, 0.0, 1.0);
+}
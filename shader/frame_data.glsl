@@ -0,0 +1,8 @@
+// per frame data, engine uploads it once per frame on first draw,
+// std140 layout must match frame_data in include/uniform_cache.hpp
+layout (std140) uniform frame_data
+{
+    mat4 view_projection;
+    // seconds since engine initialize
+    float time;
+};
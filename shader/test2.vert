@@ -1,11 +1,15 @@
 #version 330 core
 layout (location = 0) in vec3 a_position;
 layout (location = 1) in vec3 a_color;
+// per instance, engine sets (0, 0, 0, 1) and (1, 1, 1, 1) for usual draws
+layout (location = 2) in vec4 a_instance_offset; // xyz - offset, w - scale
+layout (location = 3) in vec4 a_instance_color;
+#include "frame_data.glsl"
 out vec4 v_position;
 out vec3 v_color;
 void main()
 {
-    v_position = vec4(a_position, 1.0);
-    v_color = a_color;
-    gl_Position = v_position;
-}
\ No newline at end of file
+    v_position = vec4(a_position * a_instance_offset.w + a_instance_offset.xyz, 1.0);
+    v_color = a_color * a_instance_color.rgb;
+    gl_Position = view_projection * v_position;
+}
@@ -0,0 +1,21 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+// test2.frag for offline SPIR-V build (glslangValidator -G)
+// specialization constant replaces VERTEX_COLOR define, glSpecializeShader
+// fixes it and driver drops branch not taken
+layout (constant_id = 0) const bool vertex_color = true;
+layout (location = 0) in vec4 v_position;
+layout (location = 1) in vec3 v_color;
+layout (location = 0) out vec4 FragColor;
+#include "depth_color.glsl"
+void main()
+{
+    if (vertex_color)
+    {
+        FragColor = vec4(v_color, 1.0);
+    }
+    else
+    {
+        FragColor = depth_color(v_position);
+    }
+}
@@ -0,0 +1,21 @@
+#version 450
+// test2.vert for offline SPIR-V build (glslangValidator -G), SPIR-V
+// needs explicit locations and block binding (frame_data_binding)
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_color;
+// per instance, engine sets (0, 0, 0, 1) and (1, 1, 1, 1) for usual draws
+layout (location = 2) in vec4 a_instance_offset; // xyz - offset, w - scale
+layout (location = 3) in vec4 a_instance_color;
+layout (std140, binding = 0) uniform frame_data
+{
+    mat4 view_projection;
+    float time;
+};
+layout (location = 0) out vec4 v_position;
+layout (location = 1) out vec3 v_color;
+void main()
+{
+    v_position = vec4(a_position * a_instance_offset.w + a_instance_offset.xyz, 1.0);
+    v_color = a_color * a_instance_color.rgb;
+    gl_Position = view_projection * v_position;
+}
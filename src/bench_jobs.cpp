@@ -0,0 +1,126 @@
+#include "../include/job_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// job system throughput and latency
+// usage: bench_jobs [workers] [jobs_count]
+int main(int argc, char* argv[])
+{
+    const size_t workers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+    const size_t jobs_count =
+        argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1'000'000;
+
+    my_engine::job_system jobs;
+    jobs.initialize(workers);
+
+    using clock = std::chrono::steady_clock;
+    using ms    = std::chrono::duration<double, std::milli>;
+
+    // empty jobs from one thread, cost of queueing and stealing
+    std::atomic<size_t> executed{ 0 };
+    auto                start = clock::now();
+    {
+        my_engine::job_counter counter;
+        for (size_t i = 0; i < jobs_count; ++i)
+        {
+            jobs.run([&executed] { ++executed; }, &counter);
+        }
+        jobs.wait(counter);
+    }
+    const ms flat_time = clock::now() - start;
+
+    // jobs spawning jobs, workers push to own deque
+    const size_t fan_out = 1000;
+    std::atomic<size_t> nested{ 0 };
+    start = clock::now();
+    {
+        my_engine::job_counter counter;
+        for (size_t i = 0; i < jobs_count / fan_out; ++i)
+        {
+            jobs.run(
+                [&jobs, &nested, &counter, fan_out] {
+                    for (size_t j = 0; j < fan_out; ++j)
+                    {
+                        jobs.run([&nested] { ++nested; }, &counter);
+                    }
+                },
+                &counter);
+        }
+        jobs.wait(counter);
+    }
+    const ms nested_time = clock::now() - start;
+
+    // chain of dependent jobs, each one starts when previous finished
+    const size_t chain_length = 10'000;
+    std::vector<my_engine::job_counter> links(chain_length);
+    start = clock::now();
+    jobs.run([] {}, &links[0]);
+    for (size_t i = 1; i < chain_length; ++i)
+    {
+        jobs.run_after(links[i - 1], [] {}, &links[i]);
+    }
+    jobs.wait(links.back());
+    const ms chain_time = clock::now() - start;
+
+    // time from run until job starts, one job in flight
+    const size_t        latency_samples = 10'000;
+    std::vector<double> latency;
+    latency.reserve(latency_samples);
+    for (size_t i = 0; i < latency_samples; ++i)
+    {
+        my_engine::job_counter counter;
+        clock::time_point      started;
+        const auto             queued = clock::now();
+        jobs.run([&started] { started = clock::now(); }, &counter);
+        jobs.wait(counter);
+        latency.push_back(
+            std::chrono::duration<double, std::micro>(started - queued)
+                .count());
+    }
+    std::sort(latency.begin(), latency.end());
+
+    // parallel_for over vertex like data against one thread
+    std::vector<float> data(jobs_count * 4, 1.f);
+    start = clock::now();
+    for (float& v : data)
+    {
+        v = std::sqrt(v * 2.f + 1.f);
+    }
+    const ms serial_time = clock::now() - start;
+    start                = clock::now();
+    jobs.parallel_for(data.size(), 16 * 1024, [&data](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+        {
+            data[i] = std::sqrt(data[i] * 2.f + 1.f);
+        }
+    });
+    const ms parallel_time = clock::now() - start;
+
+    const size_t worker_count = jobs.worker_count();
+    jobs.uninitialize();
+
+    const bool ok = executed == jobs_count &&
+                    nested == jobs_count / fan_out * fan_out;
+
+    std::cout << "workers:        " << worker_count << '\n'
+              << "flat jobs:      " << jobs_count / flat_time.count() * 1000.
+              << " jobs/s\n"
+              << "nested jobs:    "
+              << nested.load() / nested_time.count() * 1000. << " jobs/s\n"
+              << "dependent jobs: " << chain_length / chain_time.count() * 1000.
+              << " jobs/s\n"
+              << "latency median: " << latency[latency.size() / 2] << " us\n"
+              << "latency p99:    " << latency[latency.size() * 99 / 100]
+              << " us\n"
+              << "parallel_for:   " << serial_time.count() << " ms -> "
+              << parallel_time.count() << " ms\n"
+              << "all jobs run:   " << (ok ? "yes" : "no") << std::endl;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
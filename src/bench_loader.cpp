@@ -0,0 +1,73 @@
+#include "../include/figure_loader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// compare std::from_chars loader with operator>> on generated file
+// usage: bench_loader [triangles_count]
+int main(int argc, char* argv[])
+{
+    const size_t triangles_count =
+        argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+    const std::string path = "bench_vertexes.txt";
+
+    {
+        std::mt19937                          gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::ofstream                         file(path);
+        for (size_t i = 0; i < triangles_count * 3; ++i)
+        {
+            file << dist(gen) << ' ' << dist(gen) << ' ' << dist(gen) << "    "
+                 << (dist(gen) + 1.f) / 2.f << ' ' << (dist(gen) + 1.f) / 2.f
+                 << ' ' << (dist(gen) + 1.f) / 2.f << '\n';
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    auto                          start = clock::now();
+    std::vector<my_engine::vertex> by_stream;
+    {
+        std::ifstream       file(path);
+        my_engine::triangle tr;
+        while (file >> tr)
+        {
+            by_stream.insert(by_stream.end(), std::begin(tr.v), std::end(tr.v));
+        }
+    }
+    const std::chrono::duration<double, std::milli> stream_time =
+        clock::now() - start;
+
+    start = clock::now();
+    const std::vector<my_engine::vertex> by_loader =
+        my_engine::load_figures(path, my_engine::figure_kind::triangle);
+    const std::chrono::duration<double, std::milli> loader_time =
+        clock::now() - start;
+
+    std::remove(path.c_str());
+
+    bool same = by_stream.size() == by_loader.size();
+    for (size_t i = 0; same && i < by_stream.size(); ++i)
+    {
+        const my_engine::vertex& a = by_stream[i];
+        const my_engine::vertex& b = by_loader[i];
+        same = a.x == b.x && a.y == b.y && a.z == b.z && a.r == b.r &&
+               a.g == b.g && a.b == b.b;
+    }
+
+    std::cout << "triangles:   " << triangles_count << '\n'
+              << "operator>>:  " << stream_time.count() << " ms\n"
+              << "from_chars:  " << loader_time.count() << " ms\n"
+              << "speedup:     " << stream_time.count() / loader_time.count()
+              << "x\n"
+              << "same result: " << (same ? "yes" : "no") << std::endl;
+
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,20 +4,40 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 // #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <exception>
+#include <future>
+#include <iterator>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include <SDL2/SDL.h>
 
+#include "../include/file_watcher.hpp"
+#include "../include/gl_state.hpp"
 #include "../include/glad/glad.h"
+#include "../include/indexed_mesh.hpp"
+#include "../include/mesh.hpp"
+#include "../include/mesh_arena.hpp"
+#include "../include/program_cache.hpp"
+#include "../include/render_queue.hpp"
+#include "../include/render_thread.hpp"
 #include "../include/shader.hpp"
+#include "../include/shader_manager.hpp"
+#include "../include/shader_preprocessor.hpp"
+#include "../include/stream_buffer.hpp"
+#include "../include/uniform_cache.hpp"
+#include "../include/vertex_format.hpp"
+#include "../include/vertex_layout.hpp"
 
 namespace my_engine
 {
@@ -119,21 +139,136 @@ static bool check_input(const SDL_Event& e, const bind*& result)
 class engine_impl : public engine
 {
 public:
-    std::string initialize(std::string_view /*config*/) final;
-    bool        read_input(event& e) final;
-    void        render_triangle(const triangle&) final;
-    void        swap_buffers() final;
-    void        uninitialize() final;
+    std::string    initialize(std::string_view /*config*/) final;
+    bool           read_input(event& e) final;
+    void           render_triangle(const triangle&) final;
+    void           render_quad(const quad&) final;
+    mesh_handle    load_mesh(std::string_view path, vertex_format format) final;
+    mesh_handle    load_mesh_async(std::string_view path,
+                                   vertex_format    format) final;
+    void           render_mesh(mesh_handle) final;
+    void           render_meshes(const std::vector<mesh_handle>& visible) final;
+    void           render_instanced(mesh_handle          handle,
+                                    const instance_data* instances,
+                                    size_t               count) final;
+    void           queue_mesh(mesh_handle          handle,
+                              const instance_data& placement,
+                              uint16_t             material) final;
+    size_t         reload_changed_meshes() final;
+    void           begin_batch() final;
+    void           submit(const triangle&) final;
+    void           flush() final;
+    void           swap_buffers() final;
+    frame_stats    last_frame_stats() const final;
+    void           set_validation_policy(validation_policy) final;
+    program_handle create_program(
+        std::string_view                vertex_path,
+        std::string_view                fragment_path,
+        const std::vector<std::string>& defines = {}) final;
+    void           use_program(program_handle program) final;
+    void set_view_projection(const std::array<float, 16>& m) final;
+    void set_uniform(std::string_view name, float value) final;
+    void set_uniform(std::string_view            name,
+                     const std::array<float, 4>& value) final;
+    void set_uniform(std::string_view             name,
+                     const std::array<float, 16>& value) final;
+    job_system&    jobs() final;
+    void           uninitialize() final;
+
+    /// make GL context current on calling thread or release it
+    void make_context_current(bool current);
 
 private:
+    /// triangles collected for one shader program
+    struct batch
+    {
+        GLuint              program = 0;
+        std::vector<vertex> vertexes;
+    };
+
+    void validate_program(GLuint vao);
+    /// nullptr while mesh is loading
+    /// throw std::runtime_error for invalid or failed handle
+    const mesh* drawable(mesh_handle handle) const;
+    /// bind mesh vertex array and draw it with current program
+    void draw_mesh(const mesh& m);
+    /// sort queued packets and draw them
+    void draw_queue();
+    /// current program, stream vertex array and buffer for ring draws
+    void bind_stream();
+    /// continue in next ring region when current one is full
+    void next_stream_region();
+    /// next_stream_region if size bytes don't fit into current region
+    void reserve_stream(size_t size, size_t alignment);
+    /// upload frame_data into stream ring and bind it, first call of
+    /// frame only, every draw path calls it before draw
+    void bind_frame_data();
+
     SDL_Window*   window      = nullptr;
     size_t width = 320;
     size_t height = 240;
     SDL_GLContext gl_context  = nullptr;
     GLuint        program_id_ = 0;
+    /// vertex array object of stream buffer, bound between draws
+    GLuint        vertex_array_object = 0;
+    /// glVertexAttribFormat/glBindVertexBuffer available
+    bool          attribute_binding   = false;
 
     GLuint vertexVBO;
 
+    /// every bind of engine goes through it
+    gl_state_cache state;
+
+#ifdef NDEBUG
+    validation_policy validation = validation_policy::never;
+#else
+    validation_policy validation = validation_policy::first_use;
+#endif
+    /// program and vertex array object pairs already validated
+    std::vector<std::pair<GLuint, GLuint>> validated;
+
+    /// per frame region of ring for triangles streamed to GPU
+    static constexpr size_t stream_frame_size = 4 * 1024 * 1024;
+    stream_buffer           stream;
+    /// quad_indexes in GL_UNSIGNED_SHORT, shared by all render_quad calls
+    GLuint quad_ibo = 0;
+
+    mesh_cache meshes;
+    /// linked program binaries on disk, shader_cache/ in working directory
+    program_cache  programs;
+    shader_manager shaders;
+    /// test2.vert and test2.frag, used for invalid_program
+    program_handle default_program = invalid_program;
+    /// program of use_program, program_id_ follows its reloads
+    program_handle current_program = invalid_program;
+    /// saved files of shader/ for hot reload
+    file_watcher   shader_files;
+
+    /// shared buffers per vertex format and index type for render_meshes
+    std::vector<mesh_arena> arenas;
+    /// list and mesh versions used to build arena commands
+    std::vector<mesh_handle> arena_visible;
+    std::vector<uint32_t>    arena_versions;
+    /// listed meshes without indexes, drawn one by one
+    std::vector<mesh_handle> arena_leftovers;
+
+    job_system job_pool;
+    /// time per frame for main jobs, at least one runs every frame
+    static constexpr std::chrono::milliseconds main_jobs_budget{ 2 };
+
+    /// uniform block of all programs, valid till swap_buffers
+    frame_data frame;
+    bool       frame_data_bound = false;
+    /// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of ring offsets
+    size_t                                uniform_alignment = 256;
+    std::chrono::steady_clock::time_point start_time;
+
+    std::vector<batch> batches;
+    /// packets of queue_mesh, drawn on swap_buffers
+    render_queue       queue;
+    frame_stats        current_stats;
+    frame_stats        last_stats;
+
     bool core_or_es = true;
 };
 
@@ -243,7 +378,11 @@ std::string engine_impl::initialize(std::string_view /*config*/)
                   << profile << '\n';
     }
 
-    if (gladLoadGLES2Loader(SDL_GL_GetProcAddress) == 0)
+    // desktop loader also resolves GL 4.x entry points (glBufferStorage)
+    const int glad_loaded = core_or_es
+                                ? gladLoadGLLoader(SDL_GL_GetProcAddress)
+                                : gladLoadGLES2Loader(SDL_GL_GetProcAddress);
+    if (glad_loaded == 0)
     {
         std::clog << "error: failed to initialize glad" << std::endl;
     }
@@ -261,30 +400,128 @@ std::string engine_impl::initialize(std::string_view /*config*/)
     }
 #endif
 
+    job_pool.initialize();
+
+    // shader files are read while buffers are set up
+    const std::string        path("shader/");
+    std::future<std::string> vert_text =
+        shader_loadFile_async(job_pool, path, "test2.vert");
+    std::future<std::string> frag_text =
+        shader_loadFile_async(job_pool, path, "test2.frag");
+
     // RENDER_DOC///////////////////////////////////////////
     GLuint vertex_buffer = 0;
     glGenBuffers(1, &vertex_buffer);
     OM_GL_CHECK()
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    OM_GL_CHECK()
-    GLuint vertex_array_object = 0;
+    state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
     glGenVertexArrays(1, &vertex_array_object);
     OM_GL_CHECK()
-    glBindVertexArray(vertex_array_object);
-    OM_GL_CHECK()
+    state.bind_vertex_array(vertex_array_object);
     // RENDER_DOC///////////////////////////////////////////
 
-    const std::string path("shader/");
-    const std::string vert("test2.vert");
-    const std::string frag("test2.frag");
-    program_id_ = shader_create_program(path, vert, frag);
+    // persistent mapping needs GL 4.4, ES 3.2 map range every write
+    stream.initialize(vertex_buffer, stream_frame_size, GLAD_GL_VERSION_4_4);
+
+    {
+        const std::vector<uint16_t> indexes(std::begin(quad_indexes),
+                                            std::end(quad_indexes));
+        glGenBuffers(1, &quad_ibo);
+        OM_GL_CHECK()
+        state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, quad_ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(indexes.size() * sizeof(uint16_t)),
+                     indexes.data(),
+                     GL_STATIC_DRAW);
+        OM_GL_CHECK()
+    }
+
+    // driver compiles default program while rest is set up
+    programs.initialize("shader_cache");
+    shaders.initialize(programs, state, SDL_GL_GetProcAddress);
+    try
+    {
+        // SPIR-V of OM_SPIRV_SHADERS build skips GLSL compile in driver,
+        // constant 0 (vertex_color) selects VERTEX_COLOR variant
+        default_program = shaders.load_spirv(path + "test2_spirv.vert.spv",
+                                             path + "test2_spirv.frag.spv",
+                                             { { 0, 1 } });
+        if (default_program != invalid_program)
+        {
+            std::clog << "default program from SPIR-V" << std::endl;
+        }
+        else
+        {
+            // main files are read already, included ones are read here
+            const std::string vert_path = path + "test2.vert";
+            const std::string frag_path = path + "test2.frag";
+            const std::string vert      = vert_text.get();
+            const std::string frag      = frag_text.get();
+            default_program             = shaders.load(
+                vert_path,
+                frag_path,
+                { "VERTEX_COLOR" },
+                [&](const std::string& file) {
+                    if (file == vert_path)
+                    {
+                        return vert;
+                    }
+                    return file == frag_path ? frag : shader_read_file(file);
+                });
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        serr << "error: failed to read shader: " << ex.what();
+        return serr.str();
+    }
 
-    /// turn on rendering with just created shader program
-    glUseProgram(program_id_);
+    // stream vertex array object is specified once, draws only move first
+    // vertex inside ring, quad_ibo stays its element buffer
+    attribute_binding = GLAD_GL_VERSION_4_3 || GLAD_GL_ES_VERSION_3_1;
+    const vertex_layout_desc& stream_layout = layout_of(vertex_format::full);
+    if (attribute_binding)
+    {
+        apply_vertex_format(stream_layout, 0);
+        glBindVertexBuffer(0, stream.id(), 0, stream_layout.stride);
+        OM_GL_CHECK()
+    }
+    else
+    {
+        apply_vertex_layout(stream_layout);
+    }
+    ++current_stats.attribute_specifications;
+
+    meshes.initialize(attribute_binding, state);
+
+    // current values of instance attributes for not instanced draws,
+    // generic attributes are context state, not part of vertex arrays
+    glVertexAttrib4f(attribute_instance_offset, 0.f, 0.f, 0.f, 1.f);
+    OM_GL_CHECK()
+    glVertexAttrib4f(attribute_instance_color, 1.f, 1.f, 1.f, 1.f);
     OM_GL_CHECK()
 
-    glEnable(GL_DEPTH_TEST);
+    /// turn on rendering with default shader program, waits for link
+    current_program = default_program;
+    program_id_     = shaders.get(current_program);
+    state.use_program(program_id_);
+
+    // edited shaders are rebuilt and swapped in by swap_buffers
+    shader_files.start(path);
+
+    state.enable(GL_DEPTH_TEST);
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
     OM_GL_CHECK()
+    uniform_alignment = std::max<size_t>(static_cast<size_t>(alignment), 4);
+    start_time        = std::chrono::steady_clock::now();
+
+    if (programs.enabled())
+    {
+        std::clog << "program cache saved "
+                  << programs.time_saved().count() / 1000.0 << " ms"
+                  << std::endl;
+    }
 
     return "";
 }
@@ -322,35 +559,23 @@ bool engine_impl::read_input(my_engine::event& ev)
     return false;
 }
 
-void engine_impl::render_triangle(const triangle& t)
+void engine_impl::validate_program(GLuint vao)
 {
-    // RENDER DOC addition ////////////////////
-    glBufferData(GL_ARRAY_BUFFER, sizeof(t), &t, GL_DYNAMIC_DRAW);
-    OM_GL_CHECK()
-    glEnableVertexAttribArray(0);
-
-    GLintptr position_attr_offset = 0;
-
-    OM_GL_CHECK()
-    glVertexAttribPointer(0,
-                          3,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          sizeof(vertex),
-                          reinterpret_cast<void*>(position_attr_offset));
-    OM_GL_CHECK()
-    glEnableVertexAttribArray(1);
-    OM_GL_CHECK()
+    if (validation == validation_policy::never)
+    {
+        return;
+    }
 
-    GLintptr color_attr_offset = sizeof(float) * 3;
+    const std::pair<GLuint, GLuint> key{ program_id_, vao };
+    if (validation == validation_policy::first_use)
+    {
+        if (std::find(validated.begin(), validated.end(), key) !=
+            validated.end())
+        {
+            return;
+        }
+    }
 
-    glVertexAttribPointer(1,
-                          3,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          sizeof(vertex),
-                          reinterpret_cast<void*>(color_attr_offset));
-    OM_GL_CHECK()
     glValidateProgram(program_id_);
     OM_GL_CHECK()
 
@@ -369,37 +594,505 @@ void engine_impl::render_triangle(const triangle& t)
         std::cerr << "Error linking program:\n" << infoLog.data();
         throw std::runtime_error("error");
     }
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    ++current_stats.program_validations;
+
+    if (validation == validation_policy::first_use)
+    {
+        validated.push_back(key);
+    }
+}
+
+void engine_impl::bind_frame_data()
+{
+    if (frame_data_bound)
+    {
+        return;
+    }
+    frame.time = std::chrono::duration<float>(
+                     std::chrono::steady_clock::now() - start_time)
+                     .count();
+    // ring region is fenced per frame, so block needs no buffer of its own
+    state.bind_buffer(GL_ARRAY_BUFFER, stream.id());
+    if (stream.space_left(uniform_alignment) < sizeof(frame))
+    {
+        stream.next_region();
+    }
+    const GLintptr offset =
+        stream.write(&frame, sizeof(frame), uniform_alignment);
+    state.bind_buffer_range(GL_UNIFORM_BUFFER,
+                            frame_data_binding,
+                            stream.id(),
+                            offset,
+                            sizeof(frame));
+    frame_data_bound = true;
+}
+
+void engine_impl::next_stream_region()
+{
+    // draws after fence must not read frame data from fenced region
+    stream.next_region();
+    frame_data_bound = false;
+    bind_frame_data();
+}
+
+void engine_impl::reserve_stream(size_t size, size_t alignment)
+{
+    if (stream.space_left(alignment) < size)
+    {
+        next_stream_region();
+    }
+}
+
+void engine_impl::bind_stream()
+{
+    bind_frame_data();
+    state.use_program(program_id_);
+    state.bind_vertex_array(vertex_array_object);
+    // unsynchronized map range writes need ring bound
+    state.bind_buffer(GL_ARRAY_BUFFER, stream.id());
+}
+
+void engine_impl::render_triangle(const triangle& t)
+{
+    // RENDER DOC addition ////////////////////
+    bind_stream();
+    reserve_stream(sizeof(t), sizeof(vertex));
+    const GLintptr offset = stream.write(&t, sizeof(t), sizeof(vertex));
+    validate_program(vertex_array_object);
+
+    const GLint first = static_cast<GLint>(offset / sizeof(vertex));
+    glDrawArrays(GL_TRIANGLES, first, 3);
+    OM_GL_CHECK()
+    ++current_stats.draw_calls;
+    ++current_stats.triangles;
+}
+
+void engine_impl::render_quad(const quad& q)
+{
+    bind_stream();
+    reserve_stream(sizeof(q), sizeof(vertex));
+    const GLintptr offset = stream.write(&q, sizeof(q), sizeof(vertex));
+    validate_program(vertex_array_object);
+
+    const GLint base = static_cast<GLint>(offset / sizeof(vertex));
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, base);
+    OM_GL_CHECK()
+    ++current_stats.draw_calls;
+    current_stats.triangles += 2;
+}
+
+mesh_handle engine_impl::load_mesh(std::string_view path,
+                                   vertex_format    format)
+{
+    return meshes.load(path, format);
+}
+
+mesh_handle engine_impl::load_mesh_async(std::string_view path,
+                                         vertex_format    format)
+{
+    bool              created = false;
+    const mesh_handle handle  = meshes.reserve(path, format, created);
+    if (!created)
+    {
+        return handle;
+    }
+
+    // read and parse on worker, only upload waits for GL thread
+    job_pool.run([this, handle, format, file = std::string(path)] {
+        std::shared_ptr<mesh_data> data;
+        try
+        {
+            data = std::make_shared<mesh_data>(read_mesh_data(file, format));
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "error: load " << file << ": " << ex.what()
+                      << std::endl;
+            // mesh cache belongs to GL thread
+            job_pool.run_on_main(
+                [this, handle, error = std::string(ex.what())] {
+                    meshes.fail(handle, error);
+                });
+            return;
+        }
+        job_pool.run_on_main([this, handle, data, file] {
+            try
+            {
+                meshes.upload(handle, *data);
+                ++current_stats.meshes_uploaded;
+            }
+            catch (const std::exception& ex)
+            {
+                std::cerr << "error: upload " << file << ": " << ex.what()
+                          << std::endl;
+                meshes.fail(handle, ex.what());
+            }
+        });
+    });
+    return handle;
+}
+
+const mesh* engine_impl::drawable(mesh_handle handle) const
+{
+    const mesh* m = meshes.find(handle);
+    if (m != nullptr || meshes.pending(handle))
+    {
+        return m;
+    }
+    if (const std::string* error = meshes.failure(handle))
+    {
+        throw std::runtime_error("mesh failed to load: " + *error);
+    }
+    throw std::runtime_error("invalid mesh handle");
+}
+
+void engine_impl::render_mesh(mesh_handle handle)
+{
+    const mesh* m = drawable(handle);
+    if (m == nullptr)
+    {
+        return;
+    }
+
+    state.use_program(program_id_);
+    draw_mesh(*m);
+}
+
+void engine_impl::draw_mesh(const mesh& m)
+{
+    bind_frame_data();
+    state.bind_vertex_array(m.vao);
+    validate_program(m.vao);
+
+    if (m.ibo != 0)
+    {
+        glDrawElements(GL_TRIANGLES, m.index_count, m.index_type, nullptr);
+        OM_GL_CHECK()
+        current_stats.triangles += static_cast<size_t>(m.index_count) / 3;
+    }
+    else
+    {
+        glDrawArrays(GL_TRIANGLES, 0, m.vertex_count);
+        OM_GL_CHECK()
+        current_stats.triangles += static_cast<size_t>(m.vertex_count) / 3;
+    }
+    ++current_stats.draw_calls;
+}
+
+void engine_impl::queue_mesh(mesh_handle          handle,
+                             const instance_data& placement,
+                             uint16_t             material)
+{
+    drawable(handle);
+    draw_packet packet;
+    packet.program   = program_id_;
+    packet.material  = material;
+    packet.mesh      = handle;
+    packet.placement = placement;
+
+    // depth of placement origin in clip space of frame view_projection
+    const std::array<float, 16>& vp = frame.view_projection;
+    const float z = vp[2] * placement.x + vp[6] * placement.y +
+                    vp[10] * placement.z + vp[14];
+    const float w = vp[3] * placement.x + vp[7] * placement.y +
+                    vp[11] * placement.z + vp[15];
+    // behind viewer goes last
+    queue.push(packet, w > 0.f ? z / w : 1.f);
+}
+
+void engine_impl::draw_queue()
+{
+    if (queue.empty())
+    {
+        return;
+    }
+    queue.sort();
+
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        const draw_packet&   p = queue[i];
+        const instance_data& t = p.placement;
+        const mesh*          m = meshes.find(p.mesh);
+        if (m == nullptr)
+        {
+            continue;
+        }
+        // mesh vertex arrays do not enable instance attributes, so shader
+        // reads current generic values
+        glVertexAttrib4f(attribute_instance_offset, t.x, t.y, t.z, t.scale);
+        OM_GL_CHECK()
+        glVertexAttrib4f(attribute_instance_color, t.r, t.g, t.b, t.a);
+        OM_GL_CHECK()
+        state.use_program(p.program);
+        draw_mesh(*m);
+    }
+    queue.clear();
+
+    glVertexAttrib4f(attribute_instance_offset, 0.f, 0.f, 0.f, 1.f);
     OM_GL_CHECK()
+    glVertexAttrib4f(attribute_instance_color, 1.f, 1.f, 1.f, 1.f);
+    OM_GL_CHECK()
+}
+
+void engine_impl::render_instanced(mesh_handle          handle,
+                                   const instance_data* instances,
+                                   size_t               count)
+{
+    const mesh* m = drawable(handle);
+    if (m == nullptr)
+    {
+        return;
+    }
+
+    const GLuint vao = meshes.instanced_vao(handle);
+    bind_frame_data();
+    state.use_program(program_id_);
+    state.bind_vertex_array(vao);
+    state.bind_buffer(GL_ARRAY_BUFFER, stream.id());
+    validate_program(vao);
+
+    // instances stream through ring, split only if ring region is full
+    size_t done = 0;
+    while (done < count)
+    {
+        const size_t space =
+            stream.space_left(sizeof(instance_data)) / sizeof(instance_data);
+        if (space == 0)
+        {
+            next_stream_region();
+            continue;
+        }
+        const size_t   part   = std::min(space, count - done);
+        const GLintptr offset = stream.write(instances + done,
+                                             part * sizeof(instance_data),
+                                             sizeof(instance_data));
+        if (attribute_binding)
+        {
+            glBindVertexBuffer(1, stream.id(), offset, sizeof(instance_data));
+            OM_GL_CHECK()
+        }
+        else
+        {
+            apply_vertex_layout(describe_layout<instance_data>(), offset, 1);
+            ++current_stats.attribute_specifications;
+        }
+
+        const GLsizei instance_count = static_cast<GLsizei>(part);
+        if (m->ibo != 0)
+        {
+            glDrawElementsInstanced(GL_TRIANGLES,
+                                    m->index_count,
+                                    m->index_type,
+                                    nullptr,
+                                    instance_count);
+            OM_GL_CHECK()
+            current_stats.triangles +=
+                static_cast<size_t>(m->index_count) / 3 * part;
+        }
+        else
+        {
+            glDrawArraysInstanced(
+                GL_TRIANGLES, 0, m->vertex_count, instance_count);
+            OM_GL_CHECK()
+            current_stats.triangles +=
+                static_cast<size_t>(m->vertex_count) / 3 * part;
+        }
+        ++current_stats.draw_calls;
+        done += part;
+    }
+}
+
+void engine_impl::render_meshes(const std::vector<mesh_handle>& visible)
+{
+    std::vector<uint32_t> versions;
+    versions.reserve(visible.size());
+    for (mesh_handle handle : visible)
+    {
+        // loading mesh has version 0, its upload changes versions
+        const mesh* m = drawable(handle);
+        versions.push_back(m == nullptr ? 0 : m->version);
+    }
+
+    if (visible != arena_visible || versions != arena_versions)
+    {
+        std::vector<std::vector<draw_elements_command>> commands(
+            arenas.size());
+        arena_leftovers.clear();
+        for (mesh_handle handle : visible)
+        {
+            const mesh* m = meshes.find(handle);
+            if (m == nullptr)
+            {
+                continue;
+            }
+            if (m->ibo == 0)
+            {
+                arena_leftovers.push_back(handle);
+                continue;
+            }
+
+            auto it = std::find_if(
+                arenas.begin(), arenas.end(), [&](const mesh_arena& a) {
+                    return a.format() == m->format &&
+                           a.index_type() == m->index_type;
+                });
+            if (it == arenas.end())
+            {
+                // multi draw indirect is desktop GL 4.3 only
+                const bool indirect = core_or_es && GLAD_GL_VERSION_4_3;
+                arenas.emplace_back();
+                arenas.back().initialize(m->format,
+                                         m->index_type,
+                                         attribute_binding,
+                                         indirect,
+                                         state);
+                commands.emplace_back();
+                it = std::prev(arenas.end());
+            }
+
+            // reloaded mesh may change format or index type
+            for (mesh_arena& other : arenas)
+            {
+                if (&other != &*it)
+                {
+                    other.remove(handle);
+                }
+            }
+            const arena_range& range = it->place(handle, *m);
+            draw_elements_command c;
+            c.count       = range.index_count;
+            c.first_index = range.first_index;
+            c.base_vertex = range.base_vertex;
+            commands[static_cast<size_t>(it - arenas.begin())].push_back(c);
+        }
+        for (size_t i = 0; i < arenas.size(); ++i)
+        {
+            arenas[i].set_commands(std::move(commands[i]));
+        }
+
+        arena_visible  = visible;
+        arena_versions = std::move(versions);
+    }
 
-    // glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), &t.v[0]);
-    // OM_GL_CHECK()
-    // glEnableVertexAttribArray(0);
-    // OM_GL_CHECK()
-    // glValidateProgram(program_id_);
-    // OM_GL_CHECK()
-    // // Check the validate status
-    // GLint validate_status = 0;
-    // glGetProgramiv(program_id_, GL_VALIDATE_STATUS, &validate_status);
-    // OM_GL_CHECK()
-    // if (validate_status == GL_FALSE)
-    // {
-    //     GLint infoLen = 0;
-    //     glGetProgramiv(program_id_, GL_INFO_LOG_LENGTH, &infoLen);
-    //     OM_GL_CHECK()
-    //     std::vector<char> infoLog(static_cast<size_t>(infoLen));
-    //     glGetProgramInfoLog(program_id_, infoLen, nullptr, infoLog.data());
-    //     OM_GL_CHECK()
-    //     std::cerr << "Error linking program:\n" << infoLog.data();
-    //     throw std::runtime_error("error");
-    // }
-    // glDrawArrays(GL_TRIANGLES, 0, 3);
-    // OM_GL_CHECK()
+    bind_frame_data();
+    state.use_program(program_id_);
+    for (const mesh_arena& arena : arenas)
+    {
+        if (!arena.empty())
+        {
+            state.bind_vertex_array(arena.vao());
+            validate_program(arena.vao());
+            arena.draw(current_stats);
+        }
+    }
+
+    for (mesh_handle handle : arena_leftovers)
+    {
+        render_mesh(handle);
+    }
+}
+
+size_t engine_impl::reload_changed_meshes()
+{
+    return meshes.reload_changed();
+}
+
+void engine_impl::begin_batch()
+{
+    for (batch& b : batches)
+    {
+        b.vertexes.clear();
+    }
+}
+
+void engine_impl::submit(const triangle& t)
+{
+    auto it = std::find_if(batches.begin(), batches.end(), [&](const batch& b) {
+        return b.program == program_id_;
+    });
+    if (it == batches.end())
+    {
+        batches.push_back(batch{ program_id_, {} });
+        it = std::prev(batches.end());
+    }
+    it->vertexes.insert(it->vertexes.end(), std::begin(t.v), std::end(t.v));
+}
+
+void engine_impl::flush()
+{
+    const GLuint active_program = program_id_;
+    for (batch& b : batches)
+    {
+        if (b.vertexes.empty())
+        {
+            continue;
+        }
+        program_id_ = b.program;
+        bind_stream();
+
+        validate_program(vertex_array_object);
+
+        // split batch only if it not fit into rest of ring region
+        size_t done = 0;
+        while (done < b.vertexes.size())
+        {
+            const size_t space =
+                stream.space_left(sizeof(vertex)) / sizeof(triangle) * 3;
+            if (space == 0)
+            {
+                next_stream_region();
+                continue;
+            }
+            const size_t   count  = std::min(space, b.vertexes.size() - done);
+            const GLintptr offset = stream.write(
+                &b.vertexes[done], count * sizeof(vertex), sizeof(vertex));
+
+            const GLint first = static_cast<GLint>(offset / sizeof(vertex));
+            glDrawArrays(GL_TRIANGLES, first, static_cast<GLsizei>(count));
+            OM_GL_CHECK()
+            ++current_stats.draw_calls;
+            current_stats.triangles += count / 3;
+            done += count;
+        }
+
+        b.vertexes.clear();
+    }
+    program_id_ = active_program;
 }
 
 void engine_impl::swap_buffers()
 {
+    flush();
+    draw_queue();
+
     SDL_GL_SwapWindow(window);
+    stream.next_frame();
+    frame_data_bound = false;
+    OM_GL_CHECK_FRAME()
+
+    // uploads of async loads are main jobs, they get part of frame
+    current_stats.main_jobs += job_pool.pump_main(main_jobs_budget);
+
+    // saved shader files start rebuild, programs finished by driver since
+    // previous frame are swapped in, never waits with parallel compile
+    for (const file_change& change : shader_files.take_changes())
+    {
+        shaders.reload(change.path, change.text);
+    }
+    if (shaders.poll() != 0)
+    {
+        program_id_ = shaders.get(current_program);
+        validated.clear();
+    }
+    current_stats.program_waits += shaders.take_waits();
+    current_stats.uniform_uploads_skipped += shaders.uniforms().take_skipped();
+
+    current_stats.attribute_specifications +=
+        meshes.take_attribute_specifications();
+    current_stats.elided_state_calls += state.take_elided_calls();
+    last_stats    = current_stats;
+    current_stats = frame_stats();
 
     glClearColor(0.3f, 0.3f, 1.0f, 0.0f);
     OM_GL_CHECK()
@@ -407,23 +1100,390 @@ void engine_impl::swap_buffers()
     OM_GL_CHECK()
 }
 
+frame_stats engine_impl::last_frame_stats() const
+{
+    return last_stats;
+}
+
+void engine_impl::set_validation_policy(validation_policy policy)
+{
+    validation = policy;
+    validated.clear();
+}
+
+program_handle engine_impl::create_program(
+    std::string_view                vertex_path,
+    std::string_view                fragment_path,
+    const std::vector<std::string>& defines)
+{
+    return shaders.load(
+        std::string(vertex_path), std::string(fragment_path), defines);
+}
+
+void engine_impl::use_program(program_handle program)
+{
+    current_program = program == invalid_program ? default_program : program;
+    program_id_     = shaders.get(current_program);
+}
+
+void engine_impl::set_view_projection(const std::array<float, 16>& m)
+{
+    frame.view_projection = m;
+}
+
+void engine_impl::set_uniform(std::string_view name, float value)
+{
+    shaders.uniforms().set(program_id_, name, value);
+}
+
+void engine_impl::set_uniform(std::string_view            name,
+                              const std::array<float, 4>& value)
+{
+    shaders.uniforms().set(program_id_, name, value);
+}
+
+void engine_impl::set_uniform(std::string_view             name,
+                              const std::array<float, 16>& value)
+{
+    shaders.uniforms().set(program_id_, name, value);
+}
+
+job_system& engine_impl::jobs()
+{
+    return job_pool;
+}
+
 void engine_impl::uninitialize()
 {
+    // jobs may still use engine
+    job_pool.uninitialize();
+    shader_files.stop();
+
+    for (mesh_arena& arena : arenas)
+    {
+        arena.uninitialize();
+    }
+    arenas.clear();
+    queue.clear();
+    meshes.clear();
+    shaders.clear();
+    glDeleteBuffers(1, &quad_ibo);
+    OM_GL_CHECK()
+    state.deleted_buffer(quad_ibo);
+    stream.uninitialize();
+    state.invalidate();
     SDL_GL_DeleteContext(gl_context);
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
 
 // Create/destroy engine
+void engine_impl::make_context_current(bool current)
+{
+    if (SDL_GL_MakeCurrent(window, current ? gl_context : nullptr) != 0)
+    {
+        throw std::runtime_error(std::string("SDL_GL_MakeCurrent: ") +
+                                 SDL_GetError());
+    }
+}
+
+/// records every GL call of engine_impl into render_thread, which owns
+/// GL context after initialize, input and window stay on game thread
+class threaded_engine final : public engine
+{
+public:
+    std::string    initialize(std::string_view config) final;
+    bool           read_input(event& e) final;
+    void           render_triangle(const triangle&) final;
+    void           render_quad(const quad&) final;
+    mesh_handle    load_mesh(std::string_view path, vertex_format format) final;
+    mesh_handle    load_mesh_async(std::string_view path,
+                                   vertex_format    format) final;
+    void           render_mesh(mesh_handle) final;
+    void           render_meshes(const std::vector<mesh_handle>& visible) final;
+    void           render_instanced(mesh_handle          handle,
+                                    const instance_data* instances,
+                                    size_t               count) final;
+    void           queue_mesh(mesh_handle          handle,
+                              const instance_data& placement,
+                              uint16_t             material) final;
+    size_t         reload_changed_meshes() final;
+    void           begin_batch() final;
+    void           submit(const triangle&) final;
+    void           flush() final;
+    void           swap_buffers() final;
+    frame_stats    last_frame_stats() const final;
+    void           set_validation_policy(validation_policy) final;
+    program_handle create_program(
+        std::string_view                vertex_path,
+        std::string_view                fragment_path,
+        const std::vector<std::string>& defines = {}) final;
+    void           use_program(program_handle program) final;
+    void set_view_projection(const std::array<float, 16>& m) final;
+    void set_uniform(std::string_view name, float value) final;
+    void set_uniform(std::string_view            name,
+                     const std::array<float, 4>& value) final;
+    void set_uniform(std::string_view             name,
+                     const std::array<float, 16>& value) final;
+    job_system&    jobs() final;
+    void           uninitialize() final;
+
+private:
+    /// handle of engine_impl for handle given to game, render thread only
+    mesh_handle inner(mesh_handle handle) const;
+
+    engine_impl   impl;
+    render_thread thread;
+
+    /// game thread, handle is index plus one, same as in mesh_cache
+    std::vector<std::string> mesh_paths;
+    /// render thread, invalid_mesh if load failed
+    std::vector<mesh_handle> inner_handles;
+
+    /// game thread, number of created programs
+    program_handle program_count = 0;
+    /// render thread, same as inner_handles for programs
+    std::vector<program_handle> inner_programs;
+
+    std::atomic<size_t> reloaded{ 0 };
+    mutable std::mutex  stats_mutex;
+    frame_stats         stats;
+};
+
+std::string threaded_engine::initialize(std::string_view config)
+{
+    std::string result = impl.initialize(config);
+    if (!result.empty())
+    {
+        return result;
+    }
+    impl.make_context_current(false);
+    thread.start([this] { impl.make_context_current(true); },
+                 [this] { impl.make_context_current(false); });
+    return result;
+}
+
+bool threaded_engine::read_input(event& e)
+{
+    // SDL events belong to thread which created window
+    return impl.read_input(e);
+}
+
+void threaded_engine::render_triangle(const triangle& t)
+{
+    thread.record([this, t] { impl.render_triangle(t); });
+}
+
+void threaded_engine::render_quad(const quad& q)
+{
+    thread.record([this, q] { impl.render_quad(q); });
+}
+
+mesh_handle threaded_engine::load_mesh(std::string_view path,
+                                       vertex_format    format)
+{
+    auto it = std::find(mesh_paths.begin(), mesh_paths.end(), path);
+    if (it != mesh_paths.end())
+    {
+        return static_cast<mesh_handle>(it - mesh_paths.begin()) + 1;
+    }
+    mesh_paths.emplace_back(path);
+    const auto handle = static_cast<mesh_handle>(mesh_paths.size());
+
+    // read error is rethrown by one of next swap_buffers
+    thread.record([this, file = std::string(path), format, handle] {
+        inner_handles.resize(handle, invalid_mesh);
+        inner_handles[handle - 1] = impl.load_mesh(file, format);
+    });
+    return handle;
+}
+
+mesh_handle threaded_engine::load_mesh_async(std::string_view path,
+                                             vertex_format    format)
+{
+    auto it = std::find(mesh_paths.begin(), mesh_paths.end(), path);
+    if (it != mesh_paths.end())
+    {
+        return static_cast<mesh_handle>(it - mesh_paths.begin()) + 1;
+    }
+    mesh_paths.emplace_back(path);
+    const auto handle = static_cast<mesh_handle>(mesh_paths.size());
+
+    thread.record([this, file = std::string(path), format, handle] {
+        inner_handles.resize(handle, invalid_mesh);
+        inner_handles[handle - 1] = impl.load_mesh_async(file, format);
+    });
+    return handle;
+}
+
+mesh_handle threaded_engine::inner(mesh_handle handle) const
+{
+    if (handle == invalid_mesh || handle > inner_handles.size())
+    {
+        return invalid_mesh;
+    }
+    return inner_handles[handle - 1];
+}
+
+void threaded_engine::render_mesh(mesh_handle handle)
+{
+    thread.record([this, handle] { impl.render_mesh(inner(handle)); });
+}
+
+void threaded_engine::render_meshes(const std::vector<mesh_handle>& visible)
+{
+    thread.record([this, visible] {
+        std::vector<mesh_handle> handles(visible.size());
+        std::transform(visible.begin(),
+                       visible.end(),
+                       handles.begin(),
+                       [this](mesh_handle h) { return inner(h); });
+        impl.render_meshes(handles);
+    });
+}
+
+void threaded_engine::render_instanced(mesh_handle          handle,
+                                       const instance_data* instances,
+                                       size_t               count)
+{
+    thread.record(
+        [this, handle, copy = std::vector<instance_data>(instances,
+                                                         instances + count)] {
+            impl.render_instanced(inner(handle), copy.data(), copy.size());
+        });
+}
+
+void threaded_engine::queue_mesh(mesh_handle          handle,
+                                 const instance_data& placement,
+                                 uint16_t             material)
+{
+    thread.record([this, handle, placement, material] {
+        impl.queue_mesh(inner(handle), placement, material);
+    });
+}
+
+size_t threaded_engine::reload_changed_meshes()
+{
+    thread.record([this] { reloaded += impl.reload_changed_meshes(); });
+    // result of this call is known only after replay
+    return reloaded.exchange(0);
+}
+
+void threaded_engine::begin_batch()
+{
+    thread.record([this] { impl.begin_batch(); });
+}
+
+void threaded_engine::submit(const triangle& t)
+{
+    thread.record([this, t] { impl.submit(t); });
+}
+
+void threaded_engine::flush()
+{
+    thread.record([this] { impl.flush(); });
+}
+
+void threaded_engine::swap_buffers()
+{
+    thread.record([this] {
+        impl.swap_buffers();
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats = impl.last_frame_stats();
+    });
+    thread.hand_off();
+}
+
+frame_stats threaded_engine::last_frame_stats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
+
+void threaded_engine::set_validation_policy(validation_policy policy)
+{
+    thread.record([this, policy] { impl.set_validation_policy(policy); });
+}
+
+program_handle threaded_engine::create_program(
+    std::string_view                vertex_path,
+    std::string_view                fragment_path,
+    const std::vector<std::string>& defines)
+{
+    const program_handle handle = ++program_count;
+    thread.record([this,
+                   vertex   = std::string(vertex_path),
+                   fragment = std::string(fragment_path),
+                   defines,
+                   handle] {
+        inner_programs.resize(handle, invalid_program);
+        inner_programs[handle - 1] =
+            impl.create_program(vertex, fragment, defines);
+    });
+    return handle;
+}
+
+void threaded_engine::use_program(program_handle program)
+{
+    thread.record([this, program] {
+        impl.use_program(program == invalid_program ||
+                                 program > inner_programs.size()
+                             ? invalid_program
+                             : inner_programs[program - 1]);
+    });
+}
+
+void threaded_engine::set_view_projection(const std::array<float, 16>& m)
+{
+    thread.record([this, m] { impl.set_view_projection(m); });
+}
+
+void threaded_engine::set_uniform(std::string_view name, float value)
+{
+    thread.record([this, name = std::string(name), value] {
+        impl.set_uniform(name, value);
+    });
+}
+
+void threaded_engine::set_uniform(std::string_view            name,
+                                  const std::array<float, 4>& value)
+{
+    thread.record([this, name = std::string(name), value] {
+        impl.set_uniform(name, value);
+    });
+}
+
+void threaded_engine::set_uniform(std::string_view             name,
+                                  const std::array<float, 16>& value)
+{
+    thread.record([this, name = std::string(name), value] {
+        impl.set_uniform(name, value);
+    });
+}
+
+job_system& threaded_engine::jobs()
+{
+    return impl.jobs();
+}
+
+void threaded_engine::uninitialize()
+{
+    thread.stop();
+    impl.make_context_current(true);
+    impl.uninitialize();
+}
+
 static bool already_exist = false;
 
-engine* create_engine()
+engine* create_engine(render_mode mode)
 {
     if (already_exist)
     {
         throw std::runtime_error("engine already exist");
     }
-    engine* result = new engine_impl();
+    engine* result = mode == render_mode::render_thread
+                         ? static_cast<engine*>(new threaded_engine())
+                         : new engine_impl();
     already_exist  = true;
     return result;
 }
@@ -0,0 +1,117 @@
+#include "../include/figure_loader.hpp"
+#include "../include/mapped_file.hpp"
+
+#include <charconv>
+
+namespace my_engine
+{
+
+parse_error::parse_error(const std::string& message,
+                         size_t             line_,
+                         size_t             column_)
+    : std::runtime_error(message + " at " + std::to_string(line_) + ':' +
+                         std::to_string(column_))
+    , line(line_)
+    , column(column_)
+{
+}
+
+namespace
+{
+
+/// cursor over text which knows its line and column
+struct text_cursor
+{
+    const char* pos;
+    const char* end;
+    const char* line_start;
+    size_t      line = 1;
+
+    size_t column() const { return static_cast<size_t>(pos - line_start) + 1; }
+
+    void skip_spaces()
+    {
+        while (pos != end)
+        {
+            const char c = *pos;
+            if (c == '\n')
+            {
+                ++line;
+                line_start = pos + 1;
+            }
+            else if (c != ' ' && c != '\t' && c != '\r')
+            {
+                break;
+            }
+            ++pos;
+        }
+    }
+
+    float read_float()
+    {
+        float value = 0.f;
+        // from_chars takes no leading '+', istream did, "+-1" stays bad
+        const char* start = pos;
+        if (start != end && *start == '+')
+        {
+            ++start;
+        }
+        const bool sign_after_plus = start != pos && start != end &&
+                                     *start == '-';
+        const auto [ptr, ec] = std::from_chars(start, end, value);
+        if (sign_after_plus || ec != std::errc() ||
+            (ptr != end && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' &&
+             *ptr != '\n'))
+        {
+            throw parse_error("bad float value", line, column());
+        }
+        pos = ptr;
+        return value;
+    }
+};
+
+} // namespace
+
+void parse_figures(std::string_view     text,
+                   figure_kind          kind,
+                   std::vector<vertex>& out)
+{
+    text_cursor cursor{ text.data(), text.data() + text.size(), text.data() };
+
+    // good guess for our files: "0.0 0.0 0.0 0.0 0.0 0.0" per line
+    out.reserve(out.size() + text.size() / 24);
+
+    const size_t first = out.size();
+    for (cursor.skip_spaces(); cursor.pos != cursor.end; cursor.skip_spaces())
+    {
+        vertex v;
+        float* fields[] = { &v.x, &v.y, &v.z, &v.r, &v.g, &v.b };
+        for (float* field : fields)
+        {
+            cursor.skip_spaces();
+            if (cursor.pos == cursor.end)
+            {
+                throw parse_error(
+                    "incomplete vertex", cursor.line, cursor.column());
+            }
+            *field = cursor.read_float();
+        }
+        out.push_back(v);
+    }
+
+    const size_t record = static_cast<size_t>(kind);
+    if ((out.size() - first) % record != 0)
+    {
+        throw parse_error("incomplete figure", cursor.line, cursor.column());
+    }
+}
+
+std::vector<vertex> load_figures(const std::string& path, figure_kind kind)
+{
+    mapped_file         file(path);
+    std::vector<vertex> result;
+    parse_figures(file.view(), kind, result);
+    return result;
+}
+
+} // namespace my_engine
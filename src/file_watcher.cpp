@@ -0,0 +1,197 @@
+#include "../include/file_watcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <map>
+#endif
+
+namespace my_engine
+{
+
+namespace
+{
+/// how often stop flag (and mtimes without inotify) are checked
+constexpr std::chrono::milliseconds watch_period{ 100 };
+} // namespace
+
+file_watcher::~file_watcher()
+{
+    stop();
+}
+
+bool file_watcher::start(const std::string& directory_)
+{
+    stop();
+    directory = directory_;
+#ifdef __linux__
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify_fd < 0)
+    {
+        std::cerr << "error: inotify_init1: " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    if (inotify_add_watch(
+            notify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cerr << "error: can't watch " << directory << ": "
+                  << std::strerror(errno) << std::endl;
+        close(notify_fd);
+        notify_fd = -1;
+        return false;
+    }
+#else
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory, ec))
+    {
+        std::cerr << "error: can't watch " << directory << std::endl;
+        return false;
+    }
+#endif
+    stopping = false;
+    worker   = std::thread([this] { loop(); });
+    return true;
+}
+
+void file_watcher::stop()
+{
+    if (!worker.joinable())
+    {
+        return;
+    }
+    stopping = true;
+    worker.join();
+#ifdef __linux__
+    close(notify_fd);
+    notify_fd = -1;
+#endif
+}
+
+std::vector<file_change> file_watcher::take_changes()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<file_change>    result;
+    result.swap(changes);
+    return result;
+}
+
+void file_watcher::read_changed(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios_base::binary);
+    if (!file)
+    {
+        // removed again right after change, nothing to report
+        return;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    file_change change{ path.lexically_normal().generic_string(),
+                        text.str() };
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto same = std::find_if(
+        changes.begin(), changes.end(), [&change](const file_change& c) {
+            return c.path == change.path;
+        });
+    if (same != changes.end())
+    {
+        *same = std::move(change);
+    }
+    else
+    {
+        changes.push_back(std::move(change));
+    }
+}
+
+#ifdef __linux__
+void file_watcher::loop()
+{
+    alignas(inotify_event) char buffer[4096];
+    const std::filesystem::path root(directory);
+
+    while (!stopping)
+    {
+        pollfd ready{ notify_fd, POLLIN, 0 };
+        if (poll(&ready, 1, static_cast<int>(watch_period.count())) <= 0)
+        {
+            continue;
+        }
+        const ssize_t size = read(notify_fd, buffer, sizeof(buffer));
+        if (size <= 0)
+        {
+            continue;
+        }
+        // names only, one file saved twice in a batch is read once
+        std::vector<std::string> names;
+        for (ssize_t offset = 0; offset < size;)
+        {
+            const auto* event =
+                reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->len == 0 || (event->mask & IN_ISDIR) != 0)
+            {
+                continue;
+            }
+            std::string name(event->name);
+            if (std::find(names.begin(), names.end(), name) == names.end())
+            {
+                names.push_back(std::move(name));
+            }
+        }
+        for (const std::string& name : names)
+        {
+            read_changed(root / name);
+        }
+    }
+}
+#else
+void file_watcher::loop()
+{
+    using write_times =
+        std::map<std::filesystem::path, std::filesystem::file_time_type>;
+
+    auto scan = [this] {
+        write_times     times;
+        std::error_code ec;
+        for (const auto& item :
+             std::filesystem::directory_iterator(directory, ec))
+        {
+            if (item.is_regular_file(ec))
+            {
+                times[item.path()] = item.last_write_time(ec);
+            }
+        }
+        return times;
+    };
+
+    write_times known = scan();
+    while (!stopping)
+    {
+        std::this_thread::sleep_for(watch_period);
+        write_times current = scan();
+        for (const auto& [path, time] : current)
+        {
+            auto old = known.find(path);
+            if (old == known.end() || old->second != time)
+            {
+                read_changed(path);
+            }
+        }
+        known.swap(current);
+    }
+}
+#endif
+
+} // namespace my_engine
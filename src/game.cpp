@@ -3,19 +3,63 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
 #include <memory>
 #include <string_view>
+#include <vector>
 
-int main(int /*argc*/, char* /*argv*/[])
+int main(int argc, char* argv[])
 {
+    // game --render-thread - GL runs on own thread one frame behind
+    const bool render_thread =
+        argc > 1 && std::string_view(argv[1]) == "--render-thread";
     std::unique_ptr<my_engine::engine, void (*)(my_engine::engine*)> engine(
-        my_engine::create_engine(), my_engine::destroy_engine);
+        my_engine::create_engine(render_thread
+                                     ? my_engine::render_mode::render_thread
+                                     : my_engine::render_mode::same_thread),
+        my_engine::destroy_engine);
 
     engine->initialize("");
 
+    // mesh appears on screen once worker parsed and engine uploaded it
+    const my_engine::mesh_handle mesh =
+        engine->load_mesh_async("res/vertexes.mesh");
+    const std::vector<my_engine::mesh_handle> scene{ mesh };
+
+    // left toggles program coloring by depth, variant of default program
+    // without VERTEX_COLOR, it compiles in background
+    const my_engine::program_handle depth_program =
+        engine->create_program("shader/test2.vert", "shader/test2.frag");
+    bool depth_colors = false;
+
+    // button2 toggles grid of small mesh copies drawn with one call
+    std::vector<my_engine::instance_data> grid;
+    const int                             grid_size = 10;
+    for (int i = 0; i < grid_size * grid_size; ++i)
+    {
+        my_engine::instance_data inst;
+        inst.x     = -0.9f + 0.2f * static_cast<float>(i % grid_size);
+        inst.y     = -0.9f + 0.2f * static_cast<float>(i / grid_size);
+        inst.z     = 0.01f * static_cast<float>(i % 7);
+        inst.scale = 0.1f;
+        inst.r     = static_cast<float>(i % grid_size) / grid_size;
+        inst.b     = static_cast<float>(i / grid_size) / grid_size;
+        grid.push_back(inst);
+    }
+    bool show_grid = false;
+    // button1 draws same grid through sorted render queue, mesh per copy
+    bool queue_grid = false;
+
+    // right toggles view spinning around z, matrix goes to frame_data
+    bool  spin  = false;
+    float angle = 0.f;
+
+    // check file modification time about once per second
+    const size_t reload_period = 60;
+    size_t       frame         = 0;
+
     bool continue_loop = true;
     while (continue_loop)
     {
@@ -32,25 +76,79 @@ int main(int /*argc*/, char* /*argv*/[])
                 case my_engine::event::select_released:
                     continue_loop = false;
                     break;
+                case my_engine::event::button2_released:
+                    show_grid = !show_grid;
+                    break;
+                case my_engine::event::left_released:
+                    depth_colors = !depth_colors;
+                    break;
+                case my_engine::event::right_released:
+                    spin = !spin;
+                    break;
+                case my_engine::event::button1_released:
+                    queue_grid = !queue_grid;
+                    break;
+                case my_engine::event::start_released:
+                {
+                    const my_engine::frame_stats stats =
+                        engine->last_frame_stats();
+                    std::cout << "draw calls: " << stats.draw_calls
+                              << " triangles: " << stats.triangles
+                              << " validations: "
+                              << stats.program_validations
+                              << " attribute specifications: "
+                              << stats.attribute_specifications
+                              << " elided state calls: "
+                              << stats.elided_state_calls
+                              << " main jobs: " << stats.main_jobs
+                              << " meshes uploaded: "
+                              << stats.meshes_uploaded
+                              << " program waits: " << stats.program_waits
+                              << " uniform uploads skipped: "
+                              << stats.uniform_uploads_skipped << std::endl;
+                    break;
+                }
                 default:
                     break;
             }
         }
 
-        std::ifstream file("res/vertexes.txt");
-        if (!file)
+        if (++frame % reload_period == 0)
         {
-            std::cerr << "can't open file: vertexes.txt" << std::endl;
+            engine->reload_changed_meshes();
         }
-        else
+
+        if (spin)
         {
-            my_engine::triangle tr;
-            file >> tr;
+            angle += 0.01f;
+        }
+        const float c = std::cos(angle);
+        const float s = std::sin(angle);
+        engine->set_view_projection({ c,   s,   0.f, 0.f, //
+                                      -s,  c,   0.f, 0.f,
+                                      0.f, 0.f, 1.f, 0.f,
+                                      0.f, 0.f, 0.f, 1.f });
 
-            engine->render_triangle(tr);
+        engine->use_program(depth_colors ? depth_program
+                                         : my_engine::invalid_program);
 
-            file >> tr;
-            engine->render_triangle(tr);
+        if (show_grid && queue_grid)
+        {
+            for (size_t i = 0; i < grid.size(); ++i)
+            {
+                // two materials in checker order, sorting groups them
+                const auto material =
+                    static_cast<uint16_t>((i + i / grid_size) % 2);
+                engine->queue_mesh(mesh, grid[i], material);
+            }
+        }
+        else if (show_grid)
+        {
+            engine->render_instanced(mesh, grid.data(), grid.size());
+        }
+        else
+        {
+            engine->render_meshes(scene);
         }
 
         engine->swap_buffers();
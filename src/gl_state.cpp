@@ -0,0 +1,159 @@
+#include "../include/gl_state.hpp"
+#include "../include/shader.hpp"
+
+#include <algorithm>
+
+namespace my_engine
+{
+
+size_t gl_state_cache::target_index(GLenum target)
+{
+    return static_cast<size_t>(
+        std::find(buffer_targets.begin(), buffer_targets.end(), target) -
+        buffer_targets.begin());
+}
+
+void gl_state_cache::use_program(GLuint id)
+{
+    if (program == id)
+    {
+        ++elided;
+        return;
+    }
+    glUseProgram(id);
+    OM_GL_CHECK()
+    program = id;
+}
+
+void gl_state_cache::bind_vertex_array(GLuint vao)
+{
+    if (vertex_array == vao)
+    {
+        ++elided;
+        return;
+    }
+    glBindVertexArray(vao);
+    OM_GL_CHECK()
+    vertex_array = vao;
+    buffers[target_index(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+}
+
+void gl_state_cache::bind_buffer(GLenum target, GLuint buffer)
+{
+    const size_t index = target_index(target);
+    if (index < buffers.size() && buffers[index] == buffer)
+    {
+        ++elided;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    OM_GL_CHECK()
+    if (index < buffers.size())
+    {
+        buffers[index] = buffer;
+    }
+}
+
+void gl_state_cache::bind_buffer_range(GLenum     target,
+                                       GLuint     index,
+                                       GLuint     buffer,
+                                       GLintptr   offset,
+                                       GLsizeiptr size)
+{
+    glBindBufferRange(target, index, buffer, offset, size);
+    OM_GL_CHECK()
+    const size_t slot = target_index(target);
+    if (slot < buffers.size())
+    {
+        buffers[slot] = buffer;
+    }
+}
+
+void gl_state_cache::set_cap(GLenum cap, bool value)
+{
+    auto it = std::find_if(caps.begin(), caps.end(), [&](const auto& c) {
+        return c.first == cap;
+    });
+    if (it != caps.end() && it->second == value)
+    {
+        ++elided;
+        return;
+    }
+    if (value)
+    {
+        glEnable(cap);
+    }
+    else
+    {
+        glDisable(cap);
+    }
+    OM_GL_CHECK()
+    if (it != caps.end())
+    {
+        it->second = value;
+    }
+    else
+    {
+        caps.emplace_back(cap, value);
+    }
+}
+
+void gl_state_cache::enable(GLenum cap)
+{
+    set_cap(cap, true);
+}
+
+void gl_state_cache::disable(GLenum cap)
+{
+    set_cap(cap, false);
+}
+
+void gl_state_cache::deleted_buffer(GLuint buffer)
+{
+    if (buffer == 0)
+    {
+        return;
+    }
+    for (GLuint& bound : buffers)
+    {
+        if (bound == buffer)
+        {
+            bound = 0;
+        }
+    }
+}
+
+void gl_state_cache::deleted_vertex_array(GLuint vao)
+{
+    if (vao != 0 && vertex_array == vao)
+    {
+        vertex_array = 0;
+        buffers[target_index(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+    }
+}
+
+void gl_state_cache::deleted_program(GLuint id)
+{
+    // deleted program stays in use until other program is bound
+    if (program == id)
+    {
+        program = unknown;
+    }
+}
+
+void gl_state_cache::invalidate()
+{
+    program      = unknown;
+    vertex_array = unknown;
+    buffers      = make_unknown();
+    caps.clear();
+}
+
+size_t gl_state_cache::take_elided_calls()
+{
+    const size_t result = elided;
+    elided              = 0;
+    return result;
+}
+
+} // namespace my_engine
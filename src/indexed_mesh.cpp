@@ -0,0 +1,95 @@
+#include "../include/indexed_mesh.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace my_engine
+{
+
+namespace
+{
+
+struct vertex_bits_hash
+{
+    size_t operator()(const vertex& v) const
+    {
+        // FNV-1a over raw bytes, vertex is six floats without padding
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+        uint64_t             hash  = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(vertex); ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+struct vertex_bits_equal
+{
+    bool operator()(const vertex& a, const vertex& b) const
+    {
+        return std::memcmp(&a, &b, sizeof(vertex)) == 0;
+    }
+};
+
+} // namespace
+
+indexed_mesh weld(const std::vector<vertex>& vertexes, figure_kind kind)
+{
+    const bool quads = kind == figure_kind::quad;
+    if (vertexes.size() % (quads ? 4 : 3) != 0)
+    {
+        throw std::runtime_error("incomplete figure in vertexes");
+    }
+
+    indexed_mesh result;
+    result.indexes.reserve(quads ? vertexes.size() / 4 * 6 : vertexes.size());
+
+    std::unordered_map<vertex, uint32_t, vertex_bits_hash, vertex_bits_equal>
+        unique;
+    unique.reserve(vertexes.size());
+
+    std::vector<uint32_t> remap(vertexes.size());
+    for (size_t i = 0; i < vertexes.size(); ++i)
+    {
+        const auto next = static_cast<uint32_t>(result.vertexes.size());
+        const auto [it, inserted] = unique.emplace(vertexes[i], next);
+        if (inserted)
+        {
+            result.vertexes.push_back(vertexes[i]);
+        }
+        remap[i] = it->second;
+    }
+
+    if (quads)
+    {
+        for (size_t first = 0; first < vertexes.size(); first += 4)
+        {
+            for (uint32_t corner : quad_indexes)
+            {
+                result.indexes.push_back(remap[first + corner]);
+            }
+        }
+    }
+    else
+    {
+        result.indexes = std::move(remap);
+    }
+    return result;
+}
+
+size_t index_size(const indexed_mesh& m)
+{
+    return m.vertexes.size() <= std::numeric_limits<uint16_t>::max() + 1u
+               ? 2
+               : 4;
+}
+
+std::vector<uint16_t> indexes_16(const indexed_mesh& m)
+{
+    return std::vector<uint16_t>(m.indexes.begin(), m.indexes.end());
+}
+
+} // namespace my_engine
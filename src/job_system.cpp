@@ -0,0 +1,329 @@
+#include "../include/job_system.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+namespace
+{
+/// worker of which job system is running on this thread
+struct worker_identity
+{
+    const job_system* owner = nullptr;
+    size_t            index = 0;
+};
+thread_local worker_identity this_worker;
+
+constexpr size_t not_worker = static_cast<size_t>(-1);
+} // namespace
+
+job_system::~job_system()
+{
+    uninitialize();
+}
+
+void job_system::initialize(size_t count)
+{
+    if (!workers.empty())
+    {
+        throw std::runtime_error("job system already initialized");
+    }
+    if (count == 0)
+    {
+        const size_t hardware = std::thread::hardware_concurrency();
+        count                 = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    stopping = false;
+    queues.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        queues.push_back(std::make_unique<worker_queue>());
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        workers.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+void job_system::uninitialize()
+{
+    if (workers.empty())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers)
+    {
+        t.join();
+    }
+    workers.clear();
+    queues.clear();
+}
+
+size_t job_system::current_worker() const
+{
+    return this_worker.owner == this ? this_worker.index : not_worker;
+}
+
+void job_system::worker_loop(size_t index)
+{
+    this_worker.owner = this;
+    this_worker.index = index;
+
+    for (;;)
+    {
+        entry e;
+        if (take(index, e))
+        {
+            execute(e);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        ++sleeping;
+        wake.wait(lock, [this] { return queued.load() > 0 || stopping; });
+        --sleeping;
+        if (stopping && queued.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool job_system::take(size_t index, entry& e)
+{
+    if (index != not_worker)
+    {
+        worker_queue&               own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            e = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            --queued;
+            return true;
+        }
+    }
+
+    // start after own deque, so thieves spread over victims
+    const size_t count = queues.size();
+    const size_t first = index == not_worker ? 0 : index + 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t victim_index = (first + i) % count;
+        if (victim_index == index)
+        {
+            continue;
+        }
+        worker_queue&               victim = *queues[victim_index];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            e = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            --queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool job_system::take_main(entry& e)
+{
+    std::lock_guard<std::mutex> lock(main_mutex);
+    if (main_jobs.empty())
+    {
+        return false;
+    }
+    e = std::move(main_jobs.front());
+    main_jobs.pop_front();
+    return true;
+}
+
+void job_system::push(entry e)
+{
+    if (queues.empty())
+    {
+        throw std::runtime_error("job system not initialized");
+    }
+    size_t index = current_worker();
+    if (index == not_worker)
+    {
+        index = next_queue++ % queues.size();
+    }
+
+    // counted before insertion, so take never decrements below zero
+    ++queued;
+    {
+        worker_queue&               q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.jobs.push_back(std::move(e));
+    }
+    if (sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        wake.notify_one();
+    }
+}
+
+void job_system::execute(entry& e)
+{
+    try
+    {
+        e.fn();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "error: job: " << ex.what() << std::endl;
+    }
+    catch (...)
+    {
+        // escaping worker would call std::terminate, waiters need finish
+        std::cerr << "error: job: unknown exception" << std::endl;
+    }
+    finish(e.counter);
+}
+
+void job_system::finish(job_counter* counter)
+{
+    if (counter == nullptr)
+    {
+        return;
+    }
+
+    std::vector<job_counter::continuation> ready;
+    {
+        // waiter locks same mutex before it returns, so counter is alive
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+        ready.swap(counter->continuations);
+    }
+
+    for (job_counter::continuation& c : ready)
+    {
+        entry e{ std::move(c.fn), c.counter };
+        if (c.on_main)
+        {
+            std::lock_guard<std::mutex> lock(main_mutex);
+            main_jobs.push_back(std::move(e));
+        }
+        else
+        {
+            push(std::move(e));
+        }
+    }
+}
+
+void job_system::run(job j, job_counter* counter)
+{
+    if (counter != nullptr)
+    {
+        ++counter->count;
+    }
+    push(entry{ std::move(j), counter });
+}
+
+void job_system::run_on_main(job j, job_counter* counter)
+{
+    if (counter != nullptr)
+    {
+        ++counter->count;
+    }
+    std::lock_guard<std::mutex> lock(main_mutex);
+    main_jobs.push_back(entry{ std::move(j), counter });
+}
+
+void job_system::run_after(job_counter& dependency,
+                           job          j,
+                           job_counter* counter,
+                           bool         on_main)
+{
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (!dependency.done())
+        {
+            if (counter != nullptr)
+            {
+                ++counter->count;
+            }
+            dependency.continuations.push_back(
+                job_counter::continuation{ std::move(j), counter, on_main });
+            return;
+        }
+    }
+    if (on_main)
+    {
+        run_on_main(std::move(j), counter);
+    }
+    else
+    {
+        run(std::move(j), counter);
+    }
+}
+
+void job_system::parallel_for(
+    size_t                                     count,
+    size_t                                     chunk,
+    const std::function<void(size_t, size_t)>& body)
+{
+    chunk = std::max<size_t>(chunk, 1);
+    job_counter counter;
+    for (size_t begin = 0; begin < count; begin += chunk)
+    {
+        const size_t end = std::min(count, begin + chunk);
+        run([&body, begin, end] { body(begin, end); }, &counter);
+    }
+    wait(counter);
+}
+
+void job_system::wait(const job_counter& counter)
+{
+    const size_t index   = current_worker();
+    const bool   on_main = std::this_thread::get_id() == main_thread.load();
+    while (!counter.done())
+    {
+        entry e;
+        if ((on_main && take_main(e)) || take(index, e))
+        {
+            execute(e);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+size_t job_system::pump_main(std::chrono::steady_clock::duration budget)
+{
+    using clock = std::chrono::steady_clock;
+    main_thread = std::this_thread::get_id();
+
+    // max() budget would overflow time point
+    const clock::time_point start = clock::now();
+    const clock::time_point deadline =
+        budget >= clock::time_point::max() - start ? clock::time_point::max()
+                                                   : start + budget;
+    size_t count = 0;
+    entry  e;
+    while ((count == 0 || clock::now() < deadline) && take_main(e))
+    {
+        execute(e);
+        ++count;
+    }
+    return count;
+}
+
+} // namespace my_engine
@@ -0,0 +1,95 @@
+#include "../include/mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace my_engine
+{
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+    if (!file)
+    {
+        throw std::runtime_error("can't open file: " + path);
+    }
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    ptr    = buffer.data();
+    length = buffer.size();
+}
+
+mapped_file::~mapped_file() {}
+
+#else
+
+mapped_file::mapped_file(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("can't open file: " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) == -1)
+    {
+        ::close(fd);
+        throw std::runtime_error("can't stat file: " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    // mmap of zero bytes fails, empty file is just empty view
+    if (length != 0)
+    {
+        // pages are read here, on loading thread, not on first access
+        // which may be glBufferData on GL thread
+#ifdef MAP_POPULATE
+        const int flags = MAP_PRIVATE | MAP_POPULATE;
+#else
+        const int flags = MAP_PRIVATE;
+#endif
+        void* addr = ::mmap(nullptr, length, PROT_READ, flags, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("can't map file: " + path);
+        }
+        ptr = static_cast<const char*>(addr);
+#ifndef MAP_POPULATE
+        ::madvise(addr, length, MADV_WILLNEED);
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        volatile char touch = 0;
+        for (size_t offset = 0; offset < length; offset += page)
+        {
+            touch = ptr[offset];
+        }
+        (void)touch;
+#endif
+    }
+    // mapping stays valid after descriptor is closed
+    ::close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    if (ptr != nullptr)
+    {
+        ::munmap(const_cast<char*>(ptr), length);
+    }
+}
+
+#endif
+
+} // namespace my_engine
@@ -0,0 +1,371 @@
+#include "../include/mesh.hpp"
+#include "../include/figure_loader.hpp"
+#include "../include/indexed_mesh.hpp"
+#include "../include/mapped_file.hpp"
+#include "../include/mesh_format.hpp"
+#include "../include/mesh_optimize.hpp"
+#include "../include/shader.hpp"
+#include "../include/vertex_layout.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+mesh_data read_mesh_data(const std::string& path, vertex_format format)
+{
+    mesh_data data;
+    data.write_time = std::filesystem::last_write_time(path);
+
+    if (std::filesystem::path(path).extension() != ".mesh")
+    {
+        // parse_figures throws on bad or incomplete record, empty file is
+        // error too, editors truncate file before writing new text
+        std::vector<vertex> figures = load_figures(path, figure_kind::triangle);
+        if (figures.empty())
+        {
+            throw std::runtime_error("no triangles in " + path);
+        }
+        indexed_mesh welded = weld(figures, figure_kind::triangle);
+        const acmr_report acmr = optimize(welded);
+        std::clog << path << " ACMR: " << acmr.before << " -> " << acmr.after
+                  << std::endl;
+
+        data.format         = fit_format(welded.vertexes, format);
+        data.vertex_storage = convert_vertexes(welded.vertexes, data.format);
+        data.vertex_count   = welded.vertexes.size();
+        data.index_count    = welded.indexes.size();
+        data.index_size     = index_size(welded);
+        if (data.index_size == sizeof(uint16_t))
+        {
+            const std::vector<uint16_t> indexes = indexes_16(welded);
+            data.index_storage.assign(
+                reinterpret_cast<const unsigned char*>(indexes.data()),
+                reinterpret_cast<const unsigned char*>(indexes.data() +
+                                                       indexes.size()));
+        }
+        else
+        {
+            data.index_storage.assign(
+                reinterpret_cast<const unsigned char*>(welded.indexes.data()),
+                reinterpret_cast<const unsigned char*>(welded.indexes.data() +
+                                                       welded.indexes.size()));
+        }
+        data.vertexes = data.vertex_storage.data();
+        data.indexes  = data.index_storage.data();
+        return data;
+    }
+
+    data.file                 = std::make_unique<mapped_file>(path);
+    const mesh_file_view view = read_mesh_file(*data.file);
+    const vertex_format  formats[] = { vertex_format::full,
+                                      vertex_format::half,
+                                      vertex_format::packed };
+    const auto           it        = std::find_if(
+        std::begin(formats), std::end(formats), [&](vertex_format f) {
+            return same_vertex_layout(*view.header, mesh_header(f));
+        });
+    if (it == std::end(formats))
+    {
+        throw std::runtime_error("unsupported vertex layout: " + path);
+    }
+    data.format       = *it;
+    data.vertexes     = view.vertexes;
+    data.vertex_count = view.header->vertex_count;
+    data.indexes      = view.indexes;
+    data.index_count  = view.header->index_count;
+    data.index_size   = view.header->index_size;
+    return data;
+}
+
+/// index_count == 0 - not indexed mesh drawn with glDrawArrays
+static void upload_buffers(mesh& m, gl_state_cache& state, const mesh_data& d)
+{
+    const size_t stride = vertex_size(m.format);
+    if (m.vbo == 0)
+    {
+        glGenBuffers(1, &m.vbo);
+        OM_GL_CHECK()
+    }
+    state.bind_buffer(GL_ARRAY_BUFFER, m.vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(d.vertex_count * stride),
+                 d.vertexes,
+                 GL_STATIC_DRAW);
+    OM_GL_CHECK()
+    m.vertex_count = static_cast<GLsizei>(d.vertex_count);
+
+    m.index_count = static_cast<GLsizei>(d.index_count);
+    if (d.index_count == 0)
+    {
+        // reload may drop indexes, draws pick indexed path by ibo != 0
+        if (m.ibo != 0)
+        {
+            glDeleteBuffers(1, &m.ibo);
+            OM_GL_CHECK()
+            state.deleted_buffer(m.ibo);
+            m.ibo = 0;
+        }
+        return;
+    }
+    if (m.ibo == 0)
+    {
+        glGenBuffers(1, &m.ibo);
+        OM_GL_CHECK()
+    }
+    state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(d.index_count * d.index_size),
+                 d.indexes,
+                 GL_STATIC_DRAW);
+    OM_GL_CHECK()
+    m.index_type =
+        d.index_size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void mesh_cache::initialize(bool attribute_binding_, gl_state_cache& state_)
+{
+    attribute_binding = attribute_binding_;
+    state             = &state_;
+}
+
+void mesh_cache::upload_mesh(mesh& m, const mesh_data& data)
+{
+    // format of binary file may change on reload, rebuild on next use
+    if (m.instanced_vao != 0)
+    {
+        glDeleteVertexArrays(1, &m.instanced_vao);
+        OM_GL_CHECK()
+        state->deleted_vertex_array(m.instanced_vao);
+        m.instanced_vao = 0;
+    }
+
+    // element buffer binding belongs to vertex array object, so it has to
+    // be bound before index upload
+    if (m.vao == 0)
+    {
+        glGenVertexArrays(1, &m.vao);
+        OM_GL_CHECK()
+    }
+    state->bind_vertex_array(m.vao);
+
+    m.format     = data.format;
+    m.write_time = data.write_time;
+    m.error.clear();
+    upload_buffers(m, *state, data);
+    ++m.version;
+
+    const vertex_layout_desc& layout = layout_of(m.format);
+    if (attribute_binding)
+    {
+        apply_vertex_format(layout, 0);
+        glBindVertexBuffer(0, m.vbo, 0, layout.stride);
+        OM_GL_CHECK()
+    }
+    else
+    {
+        // upload left m.vbo bound to GL_ARRAY_BUFFER
+        apply_vertex_layout(layout);
+    }
+    ++attribute_specifications;
+}
+
+mesh_handle mesh_cache::load(std::string_view path, vertex_format format)
+{
+    auto it = std::find_if(meshes.begin(), meshes.end(), [&](const mesh& m) {
+        return m.path == path;
+    });
+    if (it != meshes.end() && it->version != 0)
+    {
+        return static_cast<mesh_handle>(it - meshes.begin()) + 1;
+    }
+
+    // read before reserve, so failed load leaves no mesh behind
+    const mesh_data data = read_mesh_data(std::string(path), format);
+    bool              created = false;
+    const mesh_handle handle  = reserve(path, format, created);
+    upload(handle, data);
+    return handle;
+}
+
+mesh_handle mesh_cache::reserve(std::string_view path,
+                                vertex_format    format,
+                                bool&            created)
+{
+    auto it = std::find_if(meshes.begin(), meshes.end(), [&](const mesh& m) {
+        return m.path == path;
+    });
+    created = it == meshes.end();
+    if (!created)
+    {
+        return static_cast<mesh_handle>(it - meshes.begin()) + 1;
+    }
+
+    mesh m;
+    m.path   = path;
+    m.format = format;
+    meshes.push_back(m);
+    return static_cast<mesh_handle>(meshes.size());
+}
+
+void mesh_cache::upload(mesh_handle handle, const mesh_data& data)
+{
+    if (handle == invalid_mesh || handle > meshes.size())
+    {
+        throw std::runtime_error("invalid mesh handle");
+    }
+    upload_mesh(meshes[handle - 1], data);
+}
+
+void mesh_cache::fail(mesh_handle handle, const std::string& error)
+{
+    if (handle == invalid_mesh || handle > meshes.size())
+    {
+        throw std::runtime_error("invalid mesh handle");
+    }
+    mesh& m = meshes[handle - 1];
+    if (m.version != 0)
+    {
+        // geometry of earlier upload stays
+        return;
+    }
+    // missing file gets min time, so any later file differs
+    std::error_code ec;
+    m.write_time = std::filesystem::last_write_time(m.path, ec);
+    if (ec)
+    {
+        m.write_time = std::filesystem::file_time_type::min();
+    }
+    m.error = error.empty() ? "unknown error" : error;
+}
+
+const mesh* mesh_cache::find(mesh_handle handle) const
+{
+    if (handle == invalid_mesh || handle > meshes.size() ||
+        meshes[handle - 1].version == 0)
+    {
+        return nullptr;
+    }
+    return &meshes[handle - 1];
+}
+
+bool mesh_cache::pending(mesh_handle handle) const
+{
+    return handle != invalid_mesh && handle <= meshes.size() &&
+           meshes[handle - 1].version == 0 && meshes[handle - 1].error.empty();
+}
+
+const std::string* mesh_cache::failure(mesh_handle handle) const
+{
+    if (handle == invalid_mesh || handle > meshes.size() ||
+        meshes[handle - 1].error.empty())
+    {
+        return nullptr;
+    }
+    return &meshes[handle - 1].error;
+}
+
+GLuint mesh_cache::instanced_vao(mesh_handle handle)
+{
+    if (find(handle) == nullptr)
+    {
+        return 0;
+    }
+    mesh& m = meshes[handle - 1];
+    if (m.instanced_vao != 0)
+    {
+        return m.instanced_vao;
+    }
+
+    glGenVertexArrays(1, &m.instanced_vao);
+    OM_GL_CHECK()
+    state->bind_vertex_array(m.instanced_vao);
+    if (m.ibo != 0)
+    {
+        state->bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m.ibo);
+    }
+
+    const vertex_layout_desc& layout = layout_of(m.format);
+    if (attribute_binding)
+    {
+        apply_vertex_format(layout, 0);
+        glBindVertexBuffer(0, m.vbo, 0, layout.stride);
+        OM_GL_CHECK()
+        apply_vertex_format(describe_layout<instance_data>(), 1);
+        glVertexBindingDivisor(1, 1);
+        OM_GL_CHECK()
+    }
+    else
+    {
+        // instance attribute pointers are set by caller for every draw
+        state->bind_buffer(GL_ARRAY_BUFFER, m.vbo);
+        apply_vertex_layout(layout);
+    }
+    ++attribute_specifications;
+    return m.instanced_vao;
+}
+
+size_t mesh_cache::reload_changed()
+{
+    size_t reloaded = 0;
+    for (mesh& m : meshes)
+    {
+        std::error_code                       ec;
+        const std::filesystem::file_time_type time =
+            std::filesystem::last_write_time(m.path, ec);
+        const bool failed = m.version == 0 && !m.error.empty();
+        if ((m.version == 0 && !failed) || ec || time == m.write_time)
+        {
+            continue;
+        }
+        try
+        {
+            upload_mesh(m, read_mesh_data(m.path, m.format));
+            ++reloaded;
+        }
+        catch (const std::exception& ex)
+        {
+            // keep previous geometry, file may be in the middle of saving
+            std::cerr << "error: reload " << m.path << ": " << ex.what()
+                      << std::endl;
+            if (failed)
+            {
+                // retry only after next change
+                m.write_time = time;
+                m.error      = ex.what();
+            }
+        }
+    }
+    return reloaded;
+}
+
+void mesh_cache::clear()
+{
+    for (mesh& m : meshes)
+    {
+        glDeleteBuffers(1, &m.vbo);
+        OM_GL_CHECK()
+        glDeleteBuffers(1, &m.ibo);
+        OM_GL_CHECK()
+        glDeleteVertexArrays(1, &m.vao);
+        OM_GL_CHECK()
+        glDeleteVertexArrays(1, &m.instanced_vao);
+        OM_GL_CHECK()
+        state->deleted_buffer(m.vbo);
+        state->deleted_buffer(m.ibo);
+        state->deleted_vertex_array(m.vao);
+        state->deleted_vertex_array(m.instanced_vao);
+    }
+    meshes.clear();
+}
+
+size_t mesh_cache::take_attribute_specifications()
+{
+    const size_t result      = attribute_specifications;
+    attribute_specifications = 0;
+    return result;
+}
+
+} // namespace my_engine
@@ -0,0 +1,323 @@
+#include "../include/mesh_arena.hpp"
+#include "../include/shader.hpp"
+#include "../include/vertex_layout.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+static size_t index_bytes(GLenum index_type)
+{
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                           : sizeof(uint32_t);
+}
+
+void mesh_arena::initialize(vertex_format   format,
+                            GLenum          index_type,
+                            bool            attribute_binding_,
+                            bool            indirect_,
+                            gl_state_cache& state_)
+{
+    format_           = format;
+    index_type_       = index_type;
+    attribute_binding = attribute_binding_;
+    indirect          = indirect_;
+    state             = &state_;
+
+    glGenVertexArrays(1, &vao_);
+    OM_GL_CHECK()
+    if (indirect)
+    {
+        glGenBuffers(1, &indirect_buffer);
+        OM_GL_CHECK()
+    }
+}
+
+void mesh_arena::uninitialize()
+{
+    glDeleteVertexArrays(1, &vao_);
+    OM_GL_CHECK()
+    glDeleteBuffers(1, &vbo);
+    OM_GL_CHECK()
+    glDeleteBuffers(1, &ibo);
+    OM_GL_CHECK()
+    glDeleteBuffers(1, &indirect_buffer);
+    OM_GL_CHECK()
+    state->deleted_vertex_array(vao_);
+    state->deleted_buffer(vbo);
+    state->deleted_buffer(ibo);
+    state->deleted_buffer(indirect_buffer);
+    vao_ = vbo = ibo = indirect_buffer = 0;
+    vertex_capacity = vertex_used = index_capacity = index_used = 0;
+    free_vertexes.clear();
+    free_indexes.clear();
+    ranges.clear();
+    commands.clear();
+}
+
+size_t mesh_arena::allocate(std::vector<free_block>& free,
+                            size_t&                  used,
+                            size_t                   size)
+{
+    auto it = std::find_if(
+        free.begin(), free.end(), [size](const free_block& b) {
+            return b.size >= size;
+        });
+    if (size == 0 || it == free.end())
+    {
+        const size_t offset = used;
+        used += size;
+        return offset;
+    }
+    const size_t offset = it->offset;
+    it->offset += size;
+    it->size -= size;
+    if (it->size == 0)
+    {
+        free.erase(it);
+    }
+    return offset;
+}
+
+void mesh_arena::release(std::vector<free_block>& free,
+                         size_t&                  used,
+                         size_t                   offset,
+                         size_t                   size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    auto next = std::find_if(
+        free.begin(), free.end(), [offset](const free_block& b) {
+            return b.offset > offset;
+        });
+    if (next != free.begin() &&
+        std::prev(next)->offset + std::prev(next)->size == offset)
+    {
+        --next;
+        next->size += size;
+    }
+    else
+    {
+        next = free.insert(next, free_block{ offset, size });
+    }
+    const auto after = std::next(next);
+    if (after != free.end() && next->offset + next->size == after->offset)
+    {
+        next->size += after->size;
+        free.erase(after);
+    }
+    // tail of buffer is free again, no block is kept for it
+    if (next->offset + next->size == used)
+    {
+        used = next->offset;
+        free.erase(next);
+    }
+}
+
+void mesh_arena::release(const arena_range& range)
+{
+    const size_t stride     = vertex_size(format_);
+    const size_t index_size = index_bytes(index_type_);
+    release(free_vertexes,
+            vertex_used,
+            static_cast<size_t>(range.base_vertex) * stride,
+            range.vertex_count * stride);
+    release(free_indexes,
+            index_used,
+            range.first_index * index_size,
+            range.index_count * index_size);
+}
+
+void mesh_arena::remove(mesh_handle handle)
+{
+    auto it = ranges.find(handle);
+    if (it != ranges.end())
+    {
+        release(it->second);
+        ranges.erase(it);
+    }
+}
+
+void mesh_arena::reserve(GLuint& buffer,
+                         size_t& capacity,
+                         size_t  used,
+                         size_t  need)
+{
+    if (need <= capacity)
+    {
+        return;
+    }
+    size_t new_capacity = std::max<size_t>(capacity * 2, 64 * 1024);
+    while (new_capacity < need)
+    {
+        new_capacity *= 2;
+    }
+
+    GLuint new_buffer = 0;
+    glGenBuffers(1, &new_buffer);
+    OM_GL_CHECK()
+    state->bind_buffer(GL_COPY_WRITE_BUFFER, new_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER,
+                 static_cast<GLsizeiptr>(new_capacity),
+                 nullptr,
+                 GL_STATIC_DRAW);
+    OM_GL_CHECK()
+    if (used != 0)
+    {
+        state->bind_buffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                            GL_COPY_WRITE_BUFFER,
+                            0,
+                            0,
+                            static_cast<GLsizeiptr>(used));
+        OM_GL_CHECK()
+    }
+    glDeleteBuffers(1, &buffer);
+    OM_GL_CHECK()
+    state->deleted_buffer(buffer);
+
+    buffer   = new_buffer;
+    capacity = new_capacity;
+    bind_buffers();
+}
+
+void mesh_arena::bind_buffers()
+{
+    state->bind_vertex_array(vao_);
+    state->bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    const vertex_layout_desc& layout = layout_of(format_);
+    if (attribute_binding)
+    {
+        apply_vertex_format(layout, 0);
+        glBindVertexBuffer(0, vbo, 0, layout.stride);
+        OM_GL_CHECK()
+    }
+    else
+    {
+        state->bind_buffer(GL_ARRAY_BUFFER, vbo);
+        apply_vertex_layout(layout);
+    }
+}
+
+const arena_range& mesh_arena::place(mesh_handle handle, const mesh& m)
+{
+    if (m.ibo == 0 || m.format != format_ || m.index_type != index_type_)
+    {
+        throw std::runtime_error("mesh does not fit arena");
+    }
+
+    auto it = ranges.find(handle);
+    if (it != ranges.end() && it->second.mesh_version == m.version)
+    {
+        return it->second;
+    }
+
+    const size_t stride       = vertex_size(format_);
+    const size_t index_size   = index_bytes(index_type_);
+    const size_t vertex_count = static_cast<size_t>(m.vertex_count);
+    const size_t index_count  = static_cast<size_t>(m.index_count);
+
+    // old data of reloaded mesh is not drawn any more, commands are rebuilt
+    // by caller after place
+    if (it != ranges.end())
+    {
+        release(it->second);
+    }
+
+    const size_t vertex_end = vertex_used;
+    const size_t index_end  = index_used;
+    const size_t vertex_offset =
+        allocate(free_vertexes, vertex_used, vertex_count * stride);
+    const size_t index_offset =
+        allocate(free_indexes, index_used, index_count * index_size);
+    reserve(vbo, vertex_capacity, vertex_end, vertex_used);
+    reserve(ibo, index_capacity, index_end, index_used);
+
+    state->bind_buffer(GL_COPY_READ_BUFFER, m.vbo);
+    state->bind_buffer(GL_COPY_WRITE_BUFFER, vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                        GL_COPY_WRITE_BUFFER,
+                        0,
+                        static_cast<GLintptr>(vertex_offset),
+                        static_cast<GLsizeiptr>(vertex_count * stride));
+    OM_GL_CHECK()
+
+    state->bind_buffer(GL_COPY_READ_BUFFER, m.ibo);
+    state->bind_buffer(GL_COPY_WRITE_BUFFER, ibo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                        GL_COPY_WRITE_BUFFER,
+                        0,
+                        static_cast<GLintptr>(index_offset),
+                        static_cast<GLsizeiptr>(index_count * index_size));
+    OM_GL_CHECK()
+
+    arena_range range;
+    range.vertex_count = static_cast<GLuint>(vertex_count);
+    range.index_count  = static_cast<GLuint>(index_count);
+    range.first_index  = static_cast<GLuint>(index_offset / index_size);
+    range.base_vertex  = static_cast<GLint>(vertex_offset / stride);
+    range.mesh_version = m.version;
+
+    return ranges[handle] = range;
+}
+
+void mesh_arena::set_commands(std::vector<draw_elements_command> list)
+{
+    commands = std::move(list);
+    if (!indirect || commands.empty())
+    {
+        return;
+    }
+    state->bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    glBufferData(
+        GL_DRAW_INDIRECT_BUFFER,
+        static_cast<GLsizeiptr>(commands.size() * sizeof(draw_elements_command)),
+        commands.data(),
+        GL_STATIC_DRAW);
+    OM_GL_CHECK()
+}
+
+void mesh_arena::draw(frame_stats& stats) const
+{
+    state->bind_vertex_array(vao_);
+
+    for (const draw_elements_command& c : commands)
+    {
+        stats.triangles += c.count / 3;
+    }
+
+    if (indirect)
+    {
+        state->bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES,
+                                    index_type_,
+                                    nullptr,
+                                    static_cast<GLsizei>(commands.size()),
+                                    0);
+        OM_GL_CHECK()
+        ++stats.draw_calls;
+        return;
+    }
+
+    const size_t index_size = index_bytes(index_type_);
+    for (const draw_elements_command& c : commands)
+    {
+        glDrawElementsBaseVertex(
+            GL_TRIANGLES,
+            static_cast<GLsizei>(c.count),
+            index_type_,
+            reinterpret_cast<void*>(
+                static_cast<GLintptr>(c.first_index * index_size)),
+            c.base_vertex);
+        OM_GL_CHECK()
+        ++stats.draw_calls;
+    }
+}
+
+} // namespace my_engine
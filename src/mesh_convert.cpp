@@ -0,0 +1,90 @@
+#include "../include/figure_loader.hpp"
+#include "../include/indexed_mesh.hpp"
+#include "../include/mesh_format.hpp"
+#include "../include/mesh_optimize.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// convert text triangles file (res/vertexes.txt format) to binary mesh
+// usage: mesh_convert input.txt output.mesh [full|half|packed]
+int main(int argc, char* argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " input.txt output.mesh [full|half|packed]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string format_name = argc == 4 ? argv[3] : "full";
+    my_engine::vertex_format format;
+    if (format_name == "full")
+    {
+        format = my_engine::vertex_format::full;
+    }
+    else if (format_name == "half")
+    {
+        format = my_engine::vertex_format::half;
+    }
+    else if (format_name == "packed")
+    {
+        format = my_engine::vertex_format::packed;
+    }
+    else
+    {
+        std::cerr << "error: unknown vertex format: " << format_name
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const std::vector<my_engine::vertex> vertexes =
+            my_engine::load_figures(argv[1], my_engine::figure_kind::triangle);
+        my_engine::indexed_mesh mesh =
+            my_engine::weld(vertexes, my_engine::figure_kind::triangle);
+        const my_engine::acmr_report acmr = my_engine::optimize(mesh);
+
+        if (my_engine::fit_format(mesh.vertexes, format) != format)
+        {
+            format      = my_engine::vertex_format::half;
+            format_name = "half";
+        }
+
+        const std::vector<unsigned char> converted =
+            my_engine::convert_vertexes(mesh.vertexes, format);
+
+        my_engine::mesh_file_header header = my_engine::mesh_header(format);
+        header.vertex_count                = mesh.vertexes.size();
+        header.index_count                 = mesh.indexes.size();
+        header.index_size =
+            static_cast<uint32_t>(my_engine::index_size(mesh));
+
+        if (header.index_size == 2)
+        {
+            const std::vector<uint16_t> indexes = my_engine::indexes_16(mesh);
+            my_engine::write_mesh_file(
+                argv[2], header, converted.data(), indexes.data());
+        }
+        else
+        {
+            my_engine::write_mesh_file(
+                argv[2], header, converted.data(), mesh.indexes.data());
+        }
+
+        std::cout << argv[2] << ": " << vertexes.size() << " -> "
+                  << mesh.vertexes.size() << ' ' << format_name
+                  << " vertexes, "
+                  << mesh.indexes.size() << " indexes, ACMR " << acmr.before
+                  << " -> " << acmr.after << std::endl;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "error: " << argv[1] << ": " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+#include "../include/mesh_format.hpp"
+#include "../include/vertex_layout.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace my_engine
+{
+
+static uint64_t align_up(uint64_t value)
+{
+    return (value + mesh_blob_alignment - 1) / mesh_blob_alignment *
+           mesh_blob_alignment;
+}
+
+mesh_file_header mesh_header(vertex_format format)
+{
+    const vertex_layout_desc& layout = layout_of(format);
+
+    mesh_file_header header;
+    header.vertex_stride   = static_cast<uint32_t>(layout.stride);
+    header.attribute_count = static_cast<uint32_t>(layout.count);
+    for (size_t i = 0; i < layout.count; ++i)
+    {
+        const vertex_attribute& a    = layout.attributes[i];
+        mesh_attribute_desc&    desc = header.attributes[i];
+        desc.location                = a.location;
+        desc.type                    = a.type;
+        desc.count                   = static_cast<uint32_t>(a.count);
+        desc.normalized              = a.normalized;
+        desc.offset                  = a.offset;
+    }
+    return header;
+}
+
+/// blob of count elements at offset lies in file after header
+/// no multiplication or addition before checks, so header values can't
+/// wrap around, counts fit GLsizei of draw calls
+static void check_blob(const mapped_file& file,
+                       uint64_t           offset,
+                       uint64_t           count,
+                       uint64_t           element_size)
+{
+    if (offset < sizeof(mesh_file_header) ||
+        offset % mesh_blob_alignment != 0)
+    {
+        throw std::runtime_error("bad mesh blob offset");
+    }
+    if (count > static_cast<uint64_t>(INT32_MAX))
+    {
+        throw std::runtime_error("mesh too large");
+    }
+    if (offset > file.size() || count > (file.size() - offset) / element_size)
+    {
+        throw std::runtime_error("mesh file truncated");
+    }
+}
+
+mesh_file_view read_mesh_file(const mapped_file& file)
+{
+    if (file.size() < sizeof(mesh_file_header))
+    {
+        throw std::runtime_error("mesh file too small");
+    }
+
+    mesh_file_view view;
+    view.header = reinterpret_cast<const mesh_file_header*>(file.data());
+
+    const mesh_file_header& h = *view.header;
+    if (h.magic != mesh_file_magic)
+    {
+        throw std::runtime_error("not a mesh file");
+    }
+    if (h.version != mesh_file_version)
+    {
+        throw std::runtime_error("unsupported mesh file version " +
+                                 std::to_string(h.version));
+    }
+    if (h.attribute_count > mesh_max_attributes || h.vertex_stride == 0)
+    {
+        throw std::runtime_error("bad mesh vertex layout");
+    }
+    if (h.index_size != 0 && h.index_size != 2 && h.index_size != 4)
+    {
+        throw std::runtime_error("bad mesh index size");
+    }
+
+    check_blob(file, h.vertex_offset, h.vertex_count, h.vertex_stride);
+    if (h.index_size == 0 && h.index_count != 0)
+    {
+        throw std::runtime_error("bad mesh index size");
+    }
+    if (h.index_count != 0)
+    {
+        check_blob(file, h.index_offset, h.index_count, h.index_size);
+    }
+
+    view.vertexes = file.data() + h.vertex_offset;
+    view.indexes = h.index_count != 0 ? file.data() + h.index_offset : nullptr;
+    return view;
+}
+
+void write_mesh_file(const std::string& path,
+                     mesh_file_header   header,
+                     const void*        vertexes,
+                     const void*        indexes)
+{
+    const uint64_t vertex_bytes = header.vertex_count * header.vertex_stride;
+    const uint64_t index_bytes  = header.index_count * header.index_size;
+
+    header.magic         = mesh_file_magic;
+    header.version       = mesh_file_version;
+    header.vertex_offset = align_up(sizeof(mesh_file_header));
+    header.index_offset =
+        index_bytes != 0 ? align_up(header.vertex_offset + vertex_bytes) : 0;
+
+    // write next to target and rename, watched mesh is never seen half
+    // written and crash never leaves half a file
+    const std::string temp = path + ".tmp";
+    std::ofstream     file(temp, std::ios_base::binary | std::ios_base::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("can't create file: " + temp);
+    }
+
+    const std::vector<char> padding(mesh_blob_alignment, '\0');
+    auto                    pad_to = [&](uint64_t offset) {
+        const auto pos = static_cast<uint64_t>(file.tellp());
+        file.write(padding.data(), static_cast<std::streamsize>(offset - pos));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad_to(header.vertex_offset);
+    file.write(static_cast<const char*>(vertexes),
+               static_cast<std::streamsize>(vertex_bytes));
+    if (index_bytes != 0)
+    {
+        pad_to(header.index_offset);
+        file.write(static_cast<const char*>(indexes),
+                   static_cast<std::streamsize>(index_bytes));
+    }
+
+    file.close();
+    std::error_code ec;
+    if (!file)
+    {
+        std::filesystem::remove(temp, ec);
+        throw std::runtime_error("can't write file: " + temp);
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec)
+    {
+        const std::string reason = ec.message();
+        std::filesystem::remove(temp, ec);
+        throw std::runtime_error("can't write file: " + path + ": " + reason);
+    }
+}
+
+bool same_vertex_layout(const mesh_file_header& a, const mesh_file_header& b)
+{
+    if (a.vertex_stride != b.vertex_stride ||
+        a.attribute_count != b.attribute_count)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.attribute_count; ++i)
+    {
+        const mesh_attribute_desc& x = a.attributes[i];
+        const mesh_attribute_desc& y = b.attributes[i];
+        if (x.location != y.location || x.type != y.type ||
+            x.count != y.count || x.normalized != y.normalized ||
+            x.offset != y.offset)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace my_engine
@@ -0,0 +1,258 @@
+#include "../include/mesh_optimize.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace my_engine
+{
+
+float compute_acmr(const std::vector<uint32_t>& indexes,
+                   size_t                       vertex_count,
+                   size_t                       cache_size)
+{
+    if (indexes.size() < 3)
+    {
+        return 0.f;
+    }
+
+    // FIFO cache, time stamp of insertion per vertex
+    std::vector<size_t> inserted(vertex_count, 0);
+    size_t              time   = cache_size + 1;
+    size_t              misses = 0;
+    for (uint32_t index : indexes)
+    {
+        if (time - inserted[index] > cache_size)
+        {
+            inserted[index] = time++;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) /
+           static_cast<float>(indexes.size() / 3);
+}
+
+namespace
+{
+
+constexpr int   forsyth_cache_size      = 32;
+constexpr float forsyth_decay_power     = 1.5f;
+constexpr float forsyth_last_tri_score  = 0.75f;
+constexpr float forsyth_valence_scale   = 2.0f;
+constexpr float forsyth_valence_power   = 0.5f;
+
+float vertex_score(int cache_position, uint32_t active_triangles)
+{
+    if (active_triangles == 0)
+    {
+        // no triangles left to draw with this vertex
+        return -1.f;
+    }
+
+    float score = 0.f;
+    if (cache_position >= 0)
+    {
+        if (cache_position < 3)
+        {
+            // used by last triangle, fixed score avoids strips
+            score = forsyth_last_tri_score;
+        }
+        else
+        {
+            const float scale = 1.f / (forsyth_cache_size - 3);
+            score             = std::pow(1.f - (cache_position - 3) * scale,
+                             forsyth_decay_power);
+        }
+    }
+    // boost vertexes with few triangles left, to finish them off
+    score += forsyth_valence_scale *
+             std::pow(static_cast<float>(active_triangles),
+                      -forsyth_valence_power);
+    return score;
+}
+
+struct forsyth_vertex
+{
+    int      cache_position   = -1;
+    uint32_t active_triangles = 0;
+    uint32_t first_triangle   = 0; // offset in adjacency list
+    float    score            = 0.f;
+};
+
+} // namespace
+
+void optimize_vertex_cache(std::vector<uint32_t>& indexes,
+                           size_t                 vertex_count)
+{
+    const size_t triangle_count = indexes.size() / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    std::vector<forsyth_vertex> vertexes(vertex_count);
+    for (uint32_t index : indexes)
+    {
+        ++vertexes[index].active_triangles;
+    }
+
+    // triangles of every vertex in one array
+    uint32_t offset = 0;
+    for (forsyth_vertex& v : vertexes)
+    {
+        v.first_triangle = offset;
+        offset += v.active_triangles;
+    }
+    std::vector<uint32_t> adjacency(offset);
+    std::vector<uint32_t> filled(vertex_count, 0);
+    for (uint32_t t = 0; t < triangle_count; ++t)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const uint32_t v = indexes[t * 3 + k];
+            adjacency[vertexes[v].first_triangle + filled[v]++] = t;
+        }
+    }
+
+    for (forsyth_vertex& v : vertexes)
+    {
+        v.score = vertex_score(v.cache_position, v.active_triangles);
+    }
+
+    // scores of triangles around cache, computed when cache changes
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool>  emitted(triangle_count, false);
+
+    std::vector<uint32_t> result;
+    result.reserve(indexes.size());
+
+    // cache holds forsyth_cache_size vertexes plus 3 just pushed out
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(forsyth_cache_size + 3);
+    next_cache.reserve(forsyth_cache_size + 3);
+
+    // cache has no live triangle: first look at recently emitted vertexes
+    // (Tipsify dead-end stack), then take next triangle in input order,
+    // both are amortized O(1), so disconnected pieces stay linear
+    std::vector<uint32_t> dead_end;
+    dead_end.reserve(indexes.size());
+    size_t best_triangle = 0;
+    size_t scan_position = 0;
+    for (size_t emitted_count = 0; emitted_count < triangle_count;
+         ++emitted_count)
+    {
+        while (best_triangle == triangle_count && !dead_end.empty())
+        {
+            const forsyth_vertex& vert = vertexes[dead_end.back()];
+            dead_end.pop_back();
+            if (vert.active_triangles != 0)
+            {
+                best_triangle = adjacency[vert.first_triangle];
+            }
+        }
+        if (best_triangle == triangle_count)
+        {
+            while (emitted[scan_position])
+            {
+                ++scan_position;
+            }
+            best_triangle = scan_position;
+        }
+
+        const size_t tri = best_triangle;
+        emitted[tri]     = true;
+
+        next_cache.clear();
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const uint32_t  v    = indexes[tri * 3 + k];
+            forsyth_vertex& vert = vertexes[v];
+            result.push_back(v);
+            next_cache.push_back(v);
+            dead_end.push_back(v);
+
+            // remove triangle from vertex adjacency
+            auto begin = adjacency.begin() + vert.first_triangle;
+            auto end   = begin + vert.active_triangles;
+            std::iter_swap(std::find(begin, end, static_cast<uint32_t>(tri)),
+                           end - 1);
+            --vert.active_triangles;
+        }
+        for (uint32_t v : cache)
+        {
+            if (std::find(next_cache.begin(), next_cache.end(), v) ==
+                next_cache.end())
+            {
+                next_cache.push_back(v);
+            }
+        }
+        std::swap(cache, next_cache);
+
+        // update scores of cached and just evicted vertexes
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            forsyth_vertex& vert = vertexes[cache[i]];
+            vert.cache_position =
+                i < forsyth_cache_size ? static_cast<int>(i) : -1;
+            vert.score = vertex_score(vert.cache_position, vert.active_triangles);
+        }
+
+        best_triangle    = triangle_count;
+        float best_score = -std::numeric_limits<float>::max();
+        for (uint32_t v : cache)
+        {
+            const forsyth_vertex& vert = vertexes[v];
+            for (uint32_t i = 0; i < vert.active_triangles; ++i)
+            {
+                const uint32_t t = adjacency[vert.first_triangle + i];
+                triangle_scores[t] = vertexes[indexes[t * 3]].score +
+                                     vertexes[indexes[t * 3 + 1]].score +
+                                     vertexes[indexes[t * 3 + 2]].score;
+                if (triangle_scores[t] > best_score)
+                {
+                    best_score    = triangle_scores[t];
+                    best_triangle = t;
+                }
+            }
+        }
+
+        if (cache.size() > forsyth_cache_size)
+        {
+            cache.resize(forsyth_cache_size);
+        }
+    }
+
+    indexes = std::move(result);
+}
+
+void optimize_vertex_fetch(indexed_mesh& m)
+{
+    constexpr uint32_t    unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(m.vertexes.size(), unused);
+    std::vector<vertex>   vertexes;
+    vertexes.reserve(m.vertexes.size());
+
+    for (uint32_t& index : m.indexes)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<uint32_t>(vertexes.size());
+            vertexes.push_back(m.vertexes[index]);
+        }
+        index = remap[index];
+    }
+    m.vertexes = std::move(vertexes);
+}
+
+acmr_report optimize(indexed_mesh& m)
+{
+    acmr_report report;
+    report.before = compute_acmr(m.indexes, m.vertexes.size());
+    optimize_vertex_cache(m.indexes, m.vertexes.size());
+    optimize_vertex_fetch(m);
+    report.after = compute_acmr(m.indexes, m.vertexes.size());
+    return report;
+}
+
+} // namespace my_engine
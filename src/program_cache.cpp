@@ -0,0 +1,235 @@
+#include "../include/program_cache.hpp"
+#include "../include/shader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace my_engine
+{
+
+namespace
+{
+constexpr char     program_magic[4] = { 'O', 'M', 'P', 'B' };
+constexpr uint32_t program_version  = 1;
+
+struct program_file_header
+{
+    char     magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t binary_format;
+    uint32_t binary_size;
+    /// compile and link time which load replaces
+    uint64_t build_time_us;
+};
+
+constexpr uint64_t fnv_offset = 14695981039346656037ull;
+constexpr uint64_t fnv_prime  = 1099511628211ull;
+
+uint64_t fnv1a(uint64_t hash, std::string_view text)
+{
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= fnv_prime;
+    }
+    // separator, so ("ab", "c") and ("a", "bc") differ
+    hash ^= 0xff;
+    hash *= fnv_prime;
+    return hash;
+}
+
+std::string gl_string(GLenum name)
+{
+    const GLubyte* value = glGetString(name);
+    OM_GL_CHECK()
+    return value == nullptr ? std::string()
+                            : reinterpret_cast<const char*>(value);
+}
+} // namespace
+
+void program_cache::initialize(const std::string& directory_)
+{
+    directory = directory_;
+    driver    = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' +
+             gl_string(GL_VERSION);
+
+    enabled_ = false;
+    if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ES_VERSION_3_0)
+    {
+        return;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    OM_GL_CHECK()
+    if (formats == 0)
+    {
+        std::clog << "program cache disabled: no program binary formats"
+                  << std::endl;
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        std::cerr << "error: program cache " << directory << ": "
+                  << ec.message() << std::endl;
+        return;
+    }
+    enabled_ = true;
+}
+
+uint64_t program_cache::key(
+    std::initializer_list<std::string_view> sources) const
+{
+    uint64_t hash = fnv1a(fnv_offset, driver);
+    for (std::string_view source : sources)
+    {
+        hash = fnv1a(hash, source);
+    }
+    return hash;
+}
+
+std::string program_cache::file_name(uint64_t key) const
+{
+    std::ostringstream name;
+    name << directory << '/' << std::hex << std::setw(16) << std::setfill('0')
+         << key << ".bin";
+    return name.str();
+}
+
+GLuint program_cache::load(uint64_t key)
+{
+    if (!enabled_)
+    {
+        return 0;
+    }
+    using clock      = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto path  = file_name(key);
+
+    std::ifstream file(path, std::ios_base::binary);
+    if (!file)
+    {
+        return 0;
+    }
+    program_file_header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !std::equal(std::begin(program_magic),
+                             std::end(program_magic),
+                             std::begin(header.magic)) ||
+        header.version != program_version || header.key != key)
+    {
+        return 0;
+    }
+    std::vector<char> binary(header.binary_size);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!file)
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    OM_GL_CHECK()
+    // driver may reject binary of other driver build, not an error
+    glProgramBinary(program,
+                    header.binary_format,
+                    binary.data(),
+                    static_cast<GLsizei>(binary.size()));
+    // GL_INVALID_ENUM is format not supported by this driver, link status
+    // below covers it, any other pending error is reported, not swallowed
+    for (GLenum err = glGetError(); err != GL_NO_ERROR; err = glGetError())
+    {
+        if (err != GL_INVALID_ENUM)
+        {
+            std::cerr << "error: " << gl_error_to_str(err)
+                      << " after glProgramBinary of " << path << std::endl;
+        }
+    }
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    OM_GL_CHECK()
+    if (linked == 0)
+    {
+        glDeleteProgram(program);
+        OM_GL_CHECK()
+        std::clog << "program cache: binary rejected, rebuild " << path
+                  << std::endl;
+        return 0;
+    }
+
+    const std::chrono::microseconds load_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(clock::now() -
+                                                              start);
+    const std::chrono::microseconds build_time(header.build_time_us);
+    saved += build_time - load_time;
+    std::clog << "program cache hit " << path << ": "
+              << load_time.count() / 1000.0 << " ms instead of "
+              << build_time.count() / 1000.0 << " ms" << std::endl;
+    return program;
+}
+
+void program_cache::store(uint64_t                  key,
+                          GLuint                    program,
+                          std::chrono::microseconds build_time)
+{
+    if (!enabled_)
+    {
+        return;
+    }
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    OM_GL_CHECK()
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    OM_GL_CHECK()
+    if (linked == 0 || size <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(size));
+    GLenum            format = 0;
+    glGetProgramBinary(program, size, &size, &format, binary.data());
+    OM_GL_CHECK()
+
+    program_file_header header{};
+    std::copy(std::begin(program_magic),
+              std::end(program_magic),
+              std::begin(header.magic));
+    header.version       = program_version;
+    header.key           = key;
+    header.binary_format = format;
+    header.binary_size   = static_cast<uint32_t>(size);
+    header.build_time_us = static_cast<uint64_t>(build_time.count());
+
+    // write next to target and rename, so crash never leaves half a file
+    const std::string path = file_name(key);
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios_base::binary | std::ios_base::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), size);
+        if (!file)
+        {
+            std::cerr << "error: can't write " << temp << std::endl;
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec)
+    {
+        std::cerr << "error: can't write " << path << ": " << ec.message()
+                  << std::endl;
+        std::filesystem::remove(temp, ec);
+    }
+}
+
+} // namespace my_engine
@@ -0,0 +1,96 @@
+#include "../include/render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace my_engine
+{
+
+static constexpr int program_bits  = 12;
+static constexpr int material_bits = 16;
+static constexpr int mesh_bits     = 16;
+static constexpr int depth_bits    = 20;
+
+static_assert(program_bits + material_bits + mesh_bits + depth_bits == 64,
+              "sort key fields must fill 64 bits");
+
+static uint64_t field(uint64_t value, int bits)
+{
+    return value & ((uint64_t(1) << bits) - 1);
+}
+
+uint64_t make_sort_key(uint32_t    program,
+                       uint16_t    material,
+                       mesh_handle mesh,
+                       float       depth)
+{
+    // NaN goes to far plane
+    const float clamped =
+        std::isnan(depth) ? 1.f : std::clamp(depth, -1.f, 1.f);
+    const uint64_t max_depth = (uint64_t(1) << depth_bits) - 1;
+    const uint64_t quantized =
+        static_cast<uint64_t>((clamped + 1.f) * 0.5f * max_depth);
+
+    return field(program, program_bits)
+               << (material_bits + mesh_bits + depth_bits) |
+           field(material, material_bits) << (mesh_bits + depth_bits) |
+           field(mesh, mesh_bits) << depth_bits | quantized;
+}
+
+void radix_sort(std::vector<sort_entry>& entries,
+                std::vector<sort_entry>& scratch)
+{
+    scratch.resize(entries.size());
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        std::array<size_t, 256> offsets{};
+        for (const sort_entry& e : entries)
+        {
+            ++offsets[(e.key >> shift) & 0xff];
+        }
+        if (std::find(offsets.begin(), offsets.end(), entries.size()) !=
+            offsets.end())
+        {
+            // all keys share this digit, pass would not move anything
+            continue;
+        }
+
+        size_t sum = 0;
+        for (size_t& offset : offsets)
+        {
+            const size_t count = offset;
+            offset             = sum;
+            sum += count;
+        }
+        for (const sort_entry& e : entries)
+        {
+            scratch[offsets[(e.key >> shift) & 0xff]++] = e;
+        }
+        entries.swap(scratch);
+    }
+}
+
+void render_queue::push(const draw_packet& packet, float depth)
+{
+    sort_entry e;
+    e.key =
+        make_sort_key(packet.program, packet.material, packet.mesh, depth);
+    e.packet = static_cast<uint32_t>(packets.size());
+    packets.push_back(packet);
+    entries.push_back(e);
+}
+
+void render_queue::sort()
+{
+    radix_sort(entries, scratch);
+}
+
+void render_queue::clear()
+{
+    packets.clear();
+    entries.clear();
+}
+
+} // namespace my_engine
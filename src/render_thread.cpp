@@ -0,0 +1,158 @@
+#include "../include/render_thread.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+render_thread::~render_thread()
+{
+    stop();
+}
+
+void render_thread::start(command on_start, command on_stop)
+{
+    if (worker.joinable())
+    {
+        throw std::runtime_error("render thread already started");
+    }
+    stopping = false;
+    alive    = true;
+    worker   = std::thread([this,
+                          on_start = std::move(on_start),
+                          on_stop  = std::move(on_stop)] {
+        loop(on_start, on_stop);
+    });
+}
+
+void render_thread::fail(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!failure)
+    {
+        failure = error;
+    }
+}
+
+void render_thread::loop(const command& on_start, const command& on_stop)
+{
+    try
+    {
+        on_start();
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+        std::lock_guard<std::mutex> lock(mutex);
+        alive = false;
+        done.notify_all();
+        return;
+    }
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return has_pending || stopping; });
+            if (!has_pending)
+            {
+                break;
+            }
+        }
+
+        // pending belongs to this thread until has_pending is reset
+        for (command& c : pending)
+        {
+            try
+            {
+                c();
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+            }
+        }
+        pending.clear();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        has_pending = false;
+        done.notify_all();
+    }
+
+    try
+    {
+        on_stop();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "error: render thread stop: " << ex.what() << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    alive = false;
+    done.notify_all();
+}
+
+void render_thread::record(command c)
+{
+    recording.push_back(std::move(c));
+}
+
+void render_thread::hand_off()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return !has_pending || !alive; });
+
+    if (!alive)
+    {
+        recording.clear();
+        throw std::runtime_error("render thread is not running");
+    }
+
+    // recording is replayed even after failure, it may create meshes and
+    // programs whose handles game already holds
+    pending.swap(recording);
+    has_pending = true;
+    wake.notify_one();
+
+    if (failure)
+    {
+        std::exception_ptr error = failure;
+        failure                  = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void render_thread::stop()
+{
+    if (!worker.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+    recording.clear();
+
+    if (failure)
+    {
+        try
+        {
+            std::rethrow_exception(failure);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "error: render thread: " << ex.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "error: render thread: unknown exception" << std::endl;
+        }
+        failure = nullptr;
+    }
+}
+
+} // namespace my_engine
@@ -1,7 +1,58 @@
 #include "../include/shader.hpp"
+#include "../include/job_system.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream> // for DEBUG
+#include <stdexcept>
+
+const char* gl_error_to_str(GLenum err)
+{
+    switch (err)
+    {
+        case GL_INVALID_ENUM:
+            return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE:
+            return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION:
+            return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION:
+            return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_OUT_OF_MEMORY:
+            return "GL_OUT_OF_MEMORY";
+    }
+    return "unknown";
+}
+
+bool gl_check_frame()
+{
+    bool   ok  = true;
+    GLenum err = glGetError();
+    while (err != GL_NO_ERROR)
+    {
+        std::cerr << gl_error_to_str(err) << std::endl;
+        ok  = false;
+        err = glGetError();
+    }
+    if (ok)
+    {
+        return true;
+    }
+
+    // error happened somewhere after previous frame check,
+    // print newest call sites first
+    const size_t count =
+        std::min(gl_call_history_next, gl_call_history_size);
+    std::cerr << "last " << count << " GL calls:" << std::endl;
+    for (size_t i = 1; i <= count; ++i)
+    {
+        const gl_call_site& site =
+            gl_call_history[(gl_call_history_next - i) % gl_call_history_size];
+        std::cerr << site.file << ':' << site.line << '(' << site.function
+                  << ')' << std::endl;
+    }
+    return false;
+}
 
 void shader_loadFile(const std::string& path,
                      const std::string& file_name,
@@ -22,12 +73,45 @@ void shader_loadFile(const std::string& path,
     *result = text;
 }
 
+std::future<std::string> shader_loadFile_async(my_engine::job_system& jobs,
+                                               const std::string&     path,
+                                               const std::string& file_name)
+{
+    auto text = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> result = text->get_future();
+    jobs.run([text, path, file_name] {
+        try
+        {
+            std::string shader_txt;
+            shader_loadFile(path, file_name, &shader_txt);
+            text->set_value(std::move(shader_txt));
+        }
+        catch (...)
+        {
+            text->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
 GLuint shader_create_shader(const std::string path,
                             const std::string file_name,
                             GLuint            type)
 {
     std::string shader_txt;
     shader_loadFile(path, file_name, &shader_txt);
+    return shader_compile(shader_txt, type);
+}
+
+GLuint shader_compile(const std::string& shader_txt, GLuint type)
+{
+    const GLuint shader = shader_compile_start(shader_txt, type);
+    shader_compile_check(shader);
+    return shader;
+}
+
+GLuint shader_compile_start(const std::string& shader_txt, GLuint type)
+{
     const char* txt    = shader_txt.data();
     GLuint      shader = glCreateShader(type);
 
@@ -36,7 +120,92 @@ GLuint shader_create_shader(const std::string path,
 
     glCompileShader(shader);
     OM_GL_CHECK()
+    return shader;
+}
+
+std::vector<uint32_t> shader_load_spirv(const std::string& path)
+{
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+    if (!file)
+    {
+        throw std::runtime_error("can't read " + path);
+    }
+    const auto            size = static_cast<size_t>(file.tellg());
+    std::vector<uint32_t> words(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(words.data()),
+              static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+    // header is 5 words, first one is magic number
+    if (!file || size % sizeof(uint32_t) != 0 || words.size() < 5 ||
+        words[0] != 0x07230203)
+    {
+        throw std::runtime_error("not SPIR-V module " + path);
+    }
+    return words;
+}
+
+/// ids of OpDecorate SpecId, driver fails specialization for others
+static std::vector<GLuint> spirv_spec_ids(const std::vector<uint32_t>& words)
+{
+    constexpr uint32_t op_decorate        = 71;
+    constexpr uint32_t decoration_spec_id = 1;
+
+    std::vector<GLuint> ids;
+    for (size_t i = 5; i < words.size();)
+    {
+        const uint32_t count  = words[i] >> 16;
+        const uint32_t opcode = words[i] & 0xffff;
+        if (count == 0)
+        {
+            break;
+        }
+        if (opcode == op_decorate && count >= 4 && i + 3 < words.size() &&
+            words[i + 2] == decoration_spec_id)
+        {
+            ids.push_back(words[i + 3]);
+        }
+        i += count;
+    }
+    return ids;
+}
+
+GLuint shader_spirv_start(const std::vector<uint32_t>&       binary,
+                          GLuint                             type,
+                          const std::vector<spirv_constant>& constants)
+{
+    GLuint shader = glCreateShader(type);
+    OM_GL_CHECK()
+    glShaderBinary(1,
+                   &shader,
+                   GL_SHADER_BINARY_FORMAT_SPIR_V,
+                   binary.data(),
+                   static_cast<GLsizei>(binary.size() * sizeof(uint32_t)));
+    OM_GL_CHECK()
 
+    const std::vector<GLuint> declared = spirv_spec_ids(binary);
+    std::vector<GLuint>       indexes;
+    std::vector<GLuint>       values;
+    for (const spirv_constant& c : constants)
+    {
+        if (std::find(declared.begin(), declared.end(), c.id) !=
+            declared.end())
+        {
+            indexes.push_back(c.id);
+            values.push_back(c.value);
+        }
+    }
+    // compile of SPIR-V, status and log as after glCompileShader
+    glSpecializeShader(shader,
+                       "main",
+                       static_cast<GLuint>(indexes.size()),
+                       indexes.data(),
+                       values.data());
+    OM_GL_CHECK()
+    return shader;
+}
+
+bool shader_compile_check(GLuint shader)
+{
     GLint ok;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
     OM_GL_CHECK()
@@ -51,7 +220,7 @@ GLuint shader_create_shader(const std::string path,
                   << log << std::endl;
     }
 
-    return shader;
+    return ok != 0;
 }
 
 GLuint shader_create_program(const std::string path,
@@ -65,9 +234,36 @@ GLuint shader_create_program(const std::string path,
         shader_create_shader(path, fragment_file_name, GL_FRAGMENT_SHADER);
     OM_GL_CHECK()
 
+    return shader_link_program(vert_shader, frag_shader);
+}
+
+GLuint shader_link_program(GLuint vert_shader,
+                           GLuint frag_shader,
+                           bool   retrievable)
+{
+    const GLuint prog =
+        shader_link_start(vert_shader, frag_shader, retrievable);
+    shader_link_check(prog);
+
+    glDeleteShader(vert_shader);
+    glDeleteShader(frag_shader);
+
+    return prog;
+}
+
+GLuint shader_link_start(GLuint vert_shader,
+                         GLuint frag_shader,
+                         bool   retrievable)
+{
     GLuint prog = glCreateProgram();
     OM_GL_CHECK()
 
+    if (retrievable)
+    {
+        glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        OM_GL_CHECK()
+    }
+
     glAttachShader(prog, vert_shader);
     OM_GL_CHECK()
     glAttachShader(prog, frag_shader);
@@ -79,7 +275,11 @@ GLuint shader_create_program(const std::string path,
     // link program after binding attribute locations
     glLinkProgram(prog);
     OM_GL_CHECK()
+    return prog;
+}
 
+bool shader_link_check(GLuint prog)
+{
     // Check the link status
     GLint linked_status = 0;
     glGetProgramiv(prog, GL_LINK_STATUS, &linked_status);
@@ -93,9 +293,5 @@ GLuint shader_create_program(const std::string path,
         glGetProgramInfoLog(prog, infoLen, nullptr, log);
         std::cout << "\nERROR\n" << log << std::endl;
     }
-    
-    glDeleteShader(vert_shader);
-    glDeleteShader(frag_shader);
-
-    return prog;
+    return linked_status != 0;
 }
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include "../include/shader_manager.hpp"
+#include "../include/shader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+// GL_KHR_parallel_shader_compile, glad is generated without extensions,
+// ARB variant has same value
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace my_engine
+{
+
+using max_compiler_threads_proc = void(APIENTRYP)(GLuint count);
+
+static bool gl_has_extension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    OM_GL_CHECK()
+    for (GLint i = 0; i < count; ++i)
+    {
+        const GLubyte* ext =
+            glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+        OM_GL_CHECK()
+        if (ext != nullptr &&
+            std::strcmp(reinterpret_cast<const char*>(ext), name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void shader_manager::initialize(program_cache&  cache_,
+                                gl_state_cache& state_,
+                                GLADloadproc    get_proc)
+{
+    cache = &cache_;
+    state = &state_;
+    uniforms_.initialize(state_);
+
+    spirv_ = false;
+    if (GLAD_GL_VERSION_4_6)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_SHADER_BINARY_FORMATS, &count);
+        OM_GL_CHECK()
+        std::vector<GLint> formats(static_cast<size_t>(count));
+        if (count > 0)
+        {
+            glGetIntegerv(GL_SHADER_BINARY_FORMATS, formats.data());
+            OM_GL_CHECK()
+        }
+        spirv_ = std::find(formats.begin(),
+                           formats.end(),
+                           GL_SHADER_BINARY_FORMAT_SPIR_V) != formats.end();
+    }
+
+    const char* proc_name = nullptr;
+    if (gl_has_extension("GL_KHR_parallel_shader_compile"))
+    {
+        proc_name = "glMaxShaderCompilerThreadsKHR";
+    }
+    else if (gl_has_extension("GL_ARB_parallel_shader_compile"))
+    {
+        proc_name = "glMaxShaderCompilerThreadsARB";
+    }
+    parallel_ = proc_name != nullptr;
+    if (!parallel_)
+    {
+        return;
+    }
+
+    // 0xFFFFFFFF - as many threads as driver likes
+    auto max_threads =
+        reinterpret_cast<max_compiler_threads_proc>(get_proc(proc_name));
+    if (max_threads != nullptr)
+    {
+        max_threads(0xFFFFFFFF);
+        OM_GL_CHECK()
+    }
+    std::clog << "parallel shader compile enabled" << std::endl;
+}
+
+static std::string normal_path(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+shader_manager::build shader_manager::start(const std::string& vertex_source,
+                                            const std::string& fragment_source)
+{
+    build b;
+    b.key     = cache->key({ vertex_source, fragment_source });
+    b.program = cache->load(b.key);
+    if (b.program == 0)
+    {
+        b.start   = std::chrono::steady_clock::now();
+        b.vert    = shader_compile_start(vertex_source, GL_VERTEX_SHADER);
+        b.frag    = shader_compile_start(fragment_source, GL_FRAGMENT_SHADER);
+        b.program = shader_link_start(b.vert, b.frag, cache->enabled());
+        b.pending = true;
+        b.elapsed = std::chrono::steady_clock::now() - b.start;
+    }
+    else
+    {
+        bind_blocks(b.program);
+    }
+    return b;
+}
+
+program_handle shader_manager::create(const std::string& vertex_source,
+                                      const std::string& fragment_source)
+{
+    entry e;
+    e.current = start(vertex_source, fragment_source);
+    programs.push_back(std::move(e));
+    return static_cast<program_handle>(programs.size());
+}
+
+shader_manager::build shader_manager::start(entry&               e,
+                                            const shader_reader& read)
+{
+    preprocessed_shader vert =
+        shader_preprocess(e.vertex_path, e.defines, read);
+    preprocessed_shader frag =
+        shader_preprocess(e.fragment_path, e.defines, read);
+
+    e.files = std::move(vert.files);
+    for (std::string& file : frag.files)
+    {
+        if (std::find(e.files.begin(), e.files.end(), file) == e.files.end())
+        {
+            e.files.push_back(std::move(file));
+        }
+    }
+    return start(vert.text, frag.text);
+}
+
+program_handle shader_manager::load(const std::string&    vertex_path,
+                                    const std::string&    fragment_path,
+                                    const shader_defines& defines,
+                                    const shader_reader&  read)
+{
+    entry e;
+    e.vertex_path   = normal_path(vertex_path);
+    e.fragment_path = normal_path(fragment_path);
+    e.defines       = normal_defines(defines);
+
+    std::string variant = e.vertex_path + '\n' + e.fragment_path;
+    for (const std::string& define : e.defines)
+    {
+        variant += '\n' + define;
+    }
+    auto known = variants.find(variant);
+    if (known != variants.end())
+    {
+        return known->second;
+    }
+
+    e.current = start(e, read);
+    programs.push_back(std::move(e));
+    const auto handle = static_cast<program_handle>(programs.size());
+    variants.emplace(std::move(variant), handle);
+    return handle;
+}
+
+program_handle shader_manager::load_spirv(
+    const std::string&                 vertex_path,
+    const std::string&                 fragment_path,
+    const std::vector<spirv_constant>& constants)
+{
+    std::error_code ec;
+    if (!spirv_ || !std::filesystem::exists(vertex_path, ec) ||
+        !std::filesystem::exists(fragment_path, ec))
+    {
+        return invalid_program;
+    }
+    const std::vector<uint32_t> vert = shader_load_spirv(vertex_path);
+    const std::vector<uint32_t> frag = shader_load_spirv(fragment_path);
+
+    std::string specialization;
+    for (const spirv_constant& c : constants)
+    {
+        specialization +=
+            std::to_string(c.id) + '=' + std::to_string(c.value) + '\n';
+    }
+    auto bytes = [](const std::vector<uint32_t>& words) {
+        return std::string_view(reinterpret_cast<const char*>(words.data()),
+                                words.size() * sizeof(uint32_t));
+    };
+
+    build b;
+    b.key     = cache->key({ bytes(vert), bytes(frag), specialization });
+    b.program = cache->load(b.key);
+    if (b.program == 0)
+    {
+        b.start   = std::chrono::steady_clock::now();
+        b.vert    = shader_spirv_start(vert, GL_VERTEX_SHADER, constants);
+        b.frag    = shader_spirv_start(frag, GL_FRAGMENT_SHADER, constants);
+        b.program = shader_link_start(b.vert, b.frag, cache->enabled());
+        b.pending = true;
+        b.elapsed = std::chrono::steady_clock::now() - b.start;
+    }
+    else
+    {
+        bind_blocks(b.program);
+    }
+
+    entry e;
+    e.current = b;
+    programs.push_back(std::move(e));
+    return static_cast<program_handle>(programs.size());
+}
+
+bool shader_manager::finish(build& b)
+{
+    if (parallel_)
+    {
+        done(b);
+    }
+    const auto wait_start = std::chrono::steady_clock::now();
+    // status queries wait for driver, logs of failed shaders are printed
+    const bool compiled =
+        shader_compile_check(b.vert) && shader_compile_check(b.frag);
+    const bool linked = compiled && shader_link_check(b.program);
+    if (!b.completed)
+    {
+        // completion is seen right now, after wait for driver
+        const auto now = std::chrono::steady_clock::now();
+        b.elapsed = parallel_ ? now - b.start : b.elapsed + (now - wait_start);
+    }
+    if (linked)
+    {
+        bind_blocks(b.program);
+        cache->store(
+            b.key,
+            b.program,
+            std::chrono::duration_cast<std::chrono::microseconds>(b.elapsed));
+    }
+
+    glDetachShader(b.program, b.vert);
+    OM_GL_CHECK()
+    glDetachShader(b.program, b.frag);
+    OM_GL_CHECK()
+    glDeleteShader(b.vert);
+    OM_GL_CHECK()
+    glDeleteShader(b.frag);
+    OM_GL_CHECK()
+    b.vert    = 0;
+    b.frag    = 0;
+    b.pending = false;
+    return linked;
+}
+
+void shader_manager::bind_blocks(GLuint program)
+{
+    // block binding is program state, not kept by binary or relink
+    const GLuint block = glGetUniformBlockIndex(program, "frame_data");
+    OM_GL_CHECK()
+    if (block != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, block, frame_data_binding);
+        OM_GL_CHECK()
+    }
+}
+
+bool shader_manager::done(build& b)
+{
+    if (!b.pending || b.completed)
+    {
+        return true;
+    }
+    GLint status = GL_FALSE;
+    glGetProgramiv(b.program, GL_COMPLETION_STATUS_KHR, &status);
+    OM_GL_CHECK()
+    if (status == GL_TRUE)
+    {
+        b.completed = true;
+        b.elapsed   = std::chrono::steady_clock::now() - b.start;
+    }
+    return b.completed;
+}
+
+void shader_manager::discard(build& b)
+{
+    if (b.pending)
+    {
+        glDeleteShader(b.vert);
+        OM_GL_CHECK()
+        glDeleteShader(b.frag);
+        OM_GL_CHECK()
+    }
+    glDeleteProgram(b.program);
+    OM_GL_CHECK()
+    state->deleted_program(b.program);
+    uniforms_.forget(b.program);
+    b = build();
+}
+
+GLuint shader_manager::get(program_handle handle)
+{
+    if (handle == invalid_program || handle > programs.size())
+    {
+        throw std::runtime_error("invalid program handle");
+    }
+    build& current = programs[handle - 1].current;
+    if (current.pending)
+    {
+        ++waits;
+        finish(current);
+    }
+    return current.program;
+}
+
+size_t shader_manager::reload(const std::string& path, const std::string& text)
+{
+    const std::string changed = normal_path(path);
+    const shader_reader read  = [&changed, &text](const std::string& file) {
+        return file == changed ? text : shader_read_file(file);
+    };
+
+    size_t count = 0;
+    for (entry& e : programs)
+    {
+        if (std::find(e.files.begin(), e.files.end(), changed) ==
+            e.files.end())
+        {
+            continue;
+        }
+        // newer save wins over replacement still compiling
+        if (e.next.program != 0)
+        {
+            discard(e.next);
+        }
+        try
+        {
+            e.next = start(e, read);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "error: reload of " << e.vertex_path << " and "
+                      << e.fragment_path << ": " << ex.what() << std::endl;
+            continue;
+        }
+        ++count;
+    }
+    return count;
+}
+
+size_t shader_manager::poll()
+{
+    size_t swapped = 0;
+    for (entry& e : programs)
+    {
+        if (e.current.pending && parallel_ && done(e.current))
+        {
+            finish(e.current);
+        }
+        if (e.next.program == 0)
+        {
+            continue;
+        }
+        // without parallel compile replacement is waited for here, only
+        // once per saved file
+        if (parallel_ && !done(e.next))
+        {
+            continue;
+        }
+        const bool linked = !e.next.pending || finish(e.next);
+        if (!linked)
+        {
+            std::cerr << "error: reload of " << e.vertex_path << " and "
+                      << e.fragment_path << " failed, old program kept"
+                      << std::endl;
+            discard(e.next);
+            continue;
+        }
+        uniforms_.replace(e.current.program, e.next.program);
+        discard(e.current);
+        e.current = e.next;
+        e.next    = build();
+        ++swapped;
+        std::clog << "reloaded " << e.vertex_path << " and "
+                  << e.fragment_path << std::endl;
+    }
+    return swapped;
+}
+
+void shader_manager::clear()
+{
+    for (entry& e : programs)
+    {
+        discard(e.current);
+        if (e.next.program != 0)
+        {
+            discard(e.next);
+        }
+    }
+    programs.clear();
+    uniforms_.clear();
+}
+
+size_t shader_manager::take_waits()
+{
+    const size_t result = waits;
+    waits               = 0;
+    return result;
+}
+
+} // namespace my_engine
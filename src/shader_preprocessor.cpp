@@ -0,0 +1,229 @@
+#include "../include/shader_preprocessor.hpp"
+#include "../include/shader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+namespace
+{
+std::string normal_path(const std::filesystem::path& path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+/// "#name" of preprocessor directive line, "# name" too, or empty
+std::string directive_of(const std::string& line)
+{
+    std::istringstream words(line);
+    std::string        directive;
+    words >> directive;
+    if (directive == "#")
+    {
+        words >> directive;
+        directive = '#' + directive;
+    }
+    return directive.empty() || directive[0] != '#' ? std::string()
+                                                    : directive;
+}
+
+/// name of #include "name" line or empty
+std::string include_name(const std::string& line)
+{
+    if (directive_of(line) != "#include")
+    {
+        return {};
+    }
+    const size_t first = line.find('"');
+    const size_t last  = line.rfind('"');
+    if (first == std::string::npos || last == first)
+    {
+        throw std::runtime_error("bad #include: " + line);
+    }
+    return line.substr(first + 1, last - first - 1);
+}
+
+bool is_version(const std::string& line)
+{
+    const size_t first = line.find_first_not_of(" \t");
+    return first != std::string::npos &&
+           line.compare(first, 8, "#version") == 0;
+}
+
+class preprocessor
+{
+public:
+    preprocessor(const shader_defines& defines_, const shader_reader& read_)
+        : defines(defines_)
+        , read(read_)
+    {
+    }
+
+    preprocessed_shader run(const std::string& path)
+    {
+        const std::string main = normal_path(path);
+        branches.assign(1, { main });
+        append(main, true);
+        return { out.str(), std::move(files) };
+    }
+
+private:
+    /// file is included once per branch, in active branch or any branch
+    /// enclosing it, so other branch of #ifdef includes it too
+    bool included(const std::string& path) const
+    {
+        return std::any_of(
+            branches.begin(),
+            branches.end(),
+            [&path](const std::vector<std::string>& branch) {
+                return std::find(branch.begin(), branch.end(), path) !=
+                       branch.end();
+            });
+    }
+
+    /// track #if nesting, it may be open across included files
+    void follow_branches(const std::string& line)
+    {
+        const std::string directive = directive_of(line);
+        if (directive == "#if" || directive == "#ifdef" ||
+            directive == "#ifndef")
+        {
+            branches.emplace_back();
+        }
+        else if ((directive == "#elif" || directive == "#else") &&
+                 branches.size() > 1)
+        {
+            branches.back().clear();
+        }
+        else if (directive == "#endif" && branches.size() > 1)
+        {
+            // unknown which branch was taken, includes of closed
+            // conditional do not count after it
+            branches.pop_back();
+        }
+    }
+
+    void append(const std::string& path, bool main)
+    {
+        // same file included in other branch keeps its source string
+        const auto   known = std::find(files.begin(), files.end(), path);
+        const size_t index = static_cast<size_t>(known - files.begin());
+        if (known == files.end())
+        {
+            files.push_back(path);
+        }
+
+        std::vector<std::string> lines;
+        std::istringstream       text(read(path));
+        for (std::string line; std::getline(text, line);)
+        {
+            lines.push_back(std::move(line));
+        }
+
+        // defines of variant follow #version of main file, #version must
+        // be first, without it they go on top
+        size_t version = lines.size();
+        if (main)
+        {
+            version = static_cast<size_t>(
+                std::find_if(lines.begin(), lines.end(), is_version) -
+                lines.begin());
+        }
+        if (version == lines.size())
+        {
+            if (main)
+            {
+                put_defines();
+            }
+            out << "#line 1 " << index << '\n';
+        }
+
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            const std::string& line = lines[i];
+            if (i == version)
+            {
+                out << line << '\n';
+                put_defines();
+                out << "#line " << i + 2 << ' ' << index << '\n';
+                continue;
+            }
+            const std::string name = include_name(line);
+            if (name.empty())
+            {
+                follow_branches(line);
+                out << line << '\n';
+                continue;
+            }
+            const std::string file = normal_path(
+                std::filesystem::path(path).parent_path() / name);
+            if (!included(file))
+            {
+                branches.back().push_back(file);
+                append(file, false);
+            }
+            out << "#line " << i + 2 << ' ' << index << '\n';
+        }
+    }
+
+    void put_defines()
+    {
+        for (const std::string& define : defines)
+        {
+            const size_t equal = define.find('=');
+            if (equal == std::string::npos)
+            {
+                out << "#define " << define << '\n';
+            }
+            else
+            {
+                out << "#define " << define.substr(0, equal) << ' '
+                    << define.substr(equal + 1) << '\n';
+            }
+        }
+    }
+
+    const shader_defines&    defines;
+    const shader_reader&     read;
+    std::ostringstream       out;
+    std::vector<std::string> files;
+    /// files included in each open conditional branch, first is
+    /// unconditional part
+    std::vector<std::vector<std::string>> branches;
+};
+} // namespace
+
+shader_defines normal_defines(shader_defines defines)
+{
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()),
+                  defines.end());
+    return defines;
+}
+
+std::string shader_read_file(const std::string& path)
+{
+    std::string text;
+    try
+    {
+        shader_loadFile("", path, &text);
+    }
+    catch (const std::exception&)
+    {
+        throw std::runtime_error("can't read shader " + path);
+    }
+    return text;
+}
+
+preprocessed_shader shader_preprocess(const std::string&    path,
+                                      const shader_defines& defines,
+                                      const shader_reader&  read)
+{
+    return preprocessor(defines, read).run(path);
+}
+
+} // namespace my_engine
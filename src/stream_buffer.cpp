@@ -0,0 +1,132 @@
+#include "../include/stream_buffer.hpp"
+#include "../include/shader.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+void stream_buffer::initialize(GLuint buffer_id, size_t size, bool is_persistent)
+{
+    buffer      = buffer_id;
+    frame_size  = size;
+    frame_index = 0;
+    persistent  = is_persistent;
+
+    const GLsizeiptr total = static_cast<GLsizeiptr>(frame_size * frames_count);
+    if (persistent)
+    {
+        const GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags);
+        OM_GL_CHECK()
+        mapped = static_cast<unsigned char*>(
+            glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags));
+        OM_GL_CHECK()
+        if (mapped == nullptr)
+        {
+            throw std::runtime_error("can't map stream buffer");
+        }
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        OM_GL_CHECK()
+    }
+}
+
+void stream_buffer::uninitialize()
+{
+    for (GLsync& fence : fences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (mapped != nullptr)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        OM_GL_CHECK()
+        mapped = nullptr;
+    }
+    frame_size = 0;
+}
+
+size_t stream_buffer::aligned_offset(size_t alignment) const
+{
+    const size_t base = frame_index * frame_size + frame_offset;
+    return (base + alignment - 1) / alignment * alignment;
+}
+
+size_t stream_buffer::space_left(size_t alignment) const
+{
+    const size_t end   = (frame_index + 1) * frame_size;
+    const size_t start = aligned_offset(alignment);
+    return start < end ? end - start : 0;
+}
+
+GLintptr stream_buffer::write(const void* data, size_t size, size_t alignment)
+{
+    if (size > space_left(alignment))
+    {
+        throw std::runtime_error("stream buffer overflow");
+    }
+    const size_t offset = aligned_offset(alignment);
+
+    if (persistent)
+    {
+        std::memcpy(mapped + offset, data, size);
+    }
+    else
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT |
+                                 GL_MAP_INVALIDATE_RANGE_BIT |
+                                 GL_MAP_UNSYNCHRONIZED_BIT;
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER,
+                                     static_cast<GLintptr>(offset),
+                                     static_cast<GLsizeiptr>(size),
+                                     flags);
+        OM_GL_CHECK()
+        std::memcpy(ptr, data, size);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        OM_GL_CHECK()
+    }
+
+    frame_offset = offset + size - frame_index * frame_size;
+    return static_cast<GLintptr>(offset);
+}
+
+void stream_buffer::next_region()
+{
+    fences[frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    OM_GL_CHECK()
+
+    frame_index  = (frame_index + 1) % frames_count;
+    frame_offset = 0;
+
+    GLsync& fence = fences[frame_index];
+    if (fence != nullptr)
+    {
+        // normally already signaled, GPU is at most two regions behind
+        const GLuint64 timeout_ns = 1'000'000'000;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(
+                fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            std::cerr << "error: stream buffer wait failed" << std::endl;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+} // namespace my_engine
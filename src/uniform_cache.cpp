@@ -0,0 +1,183 @@
+#include "../include/uniform_cache.hpp"
+#include "../include/shader.hpp"
+
+#include <algorithm>
+
+namespace my_engine
+{
+
+void uniform_cache::initialize(gl_state_cache& state_)
+{
+    state = &state_;
+}
+
+uniform_cache::uniform& uniform_cache::find(GLuint           program,
+                                            std::string_view name)
+{
+    std::vector<uniform>& uniforms = programs[program];
+    auto                  it       = std::find_if(
+        uniforms.begin(), uniforms.end(), [name](const uniform& u) {
+            return u.name == name;
+        });
+    if (it != uniforms.end())
+    {
+        return *it;
+    }
+    uniform u;
+    u.name     = std::string(name);
+    u.location = glGetUniformLocation(program, u.name.c_str());
+    OM_GL_CHECK()
+    uniforms.push_back(std::move(u));
+    return uniforms.back();
+}
+
+GLint uniform_cache::location(GLuint program, std::string_view name)
+{
+    return find(program, name).location;
+}
+
+bool uniform_cache::set(GLuint program, std::string_view name, GLint value)
+{
+    uniform& u = find(program, name);
+    if (u.location < 0)
+    {
+        return false;
+    }
+    if (u.type == GL_INT && u.int_value == value)
+    {
+        ++skipped;
+        return true;
+    }
+    u.type      = GL_INT;
+    u.int_value = value;
+    upload(program, u);
+    return true;
+}
+
+bool uniform_cache::set(GLuint program, std::string_view name, float value)
+{
+    return set_floats(program, name, GL_FLOAT, &value, 1);
+}
+
+bool uniform_cache::set(GLuint                      program,
+                        std::string_view            name,
+                        const std::array<float, 2>& value)
+{
+    return set_floats(program, name, GL_FLOAT_VEC2, value.data(), 2);
+}
+
+bool uniform_cache::set(GLuint                      program,
+                        std::string_view            name,
+                        const std::array<float, 3>& value)
+{
+    return set_floats(program, name, GL_FLOAT_VEC3, value.data(), 3);
+}
+
+bool uniform_cache::set(GLuint                      program,
+                        std::string_view            name,
+                        const std::array<float, 4>& value)
+{
+    return set_floats(program, name, GL_FLOAT_VEC4, value.data(), 4);
+}
+
+bool uniform_cache::set(GLuint                       program,
+                        std::string_view             name,
+                        const std::array<float, 16>& value)
+{
+    return set_floats(program, name, GL_FLOAT_MAT4, value.data(), 16);
+}
+
+bool uniform_cache::set_floats(GLuint           program,
+                               std::string_view name,
+                               GLenum           type,
+                               const float*     value,
+                               size_t           count)
+{
+    uniform& u = find(program, name);
+    if (u.location < 0)
+    {
+        return false;
+    }
+    if (u.type == type && std::equal(value, value + count, u.value.begin()))
+    {
+        ++skipped;
+        return true;
+    }
+    u.type = type;
+    std::copy(value, value + count, u.value.begin());
+    upload(program, u);
+    return true;
+}
+
+void uniform_cache::upload(GLuint program, const uniform& u)
+{
+    // glUniform* writes uniform of bound program
+    state->use_program(program);
+    const GLfloat* v = u.value.data();
+    switch (u.type)
+    {
+        case GL_INT:
+            glUniform1i(u.location, u.int_value);
+            break;
+        case GL_FLOAT:
+            glUniform1fv(u.location, 1, v);
+            break;
+        case GL_FLOAT_VEC2:
+            glUniform2fv(u.location, 1, v);
+            break;
+        case GL_FLOAT_VEC3:
+            glUniform3fv(u.location, 1, v);
+            break;
+        case GL_FLOAT_VEC4:
+            glUniform4fv(u.location, 1, v);
+            break;
+        case GL_FLOAT_MAT4:
+            glUniformMatrix4fv(u.location, 1, GL_FALSE, v);
+            break;
+        default:
+            return;
+    }
+    OM_GL_CHECK()
+}
+
+void uniform_cache::replace(GLuint old_program, GLuint new_program)
+{
+    auto old = programs.find(old_program);
+    if (old == programs.end())
+    {
+        return;
+    }
+    std::vector<uniform> uniforms = std::move(old->second);
+    programs.erase(old);
+
+    // names stay, locations may differ in rebuilt program
+    for (uniform& u : uniforms)
+    {
+        u.location = glGetUniformLocation(new_program, u.name.c_str());
+        OM_GL_CHECK()
+        if (u.location >= 0 && u.type != GL_NONE)
+        {
+            upload(new_program, u);
+        }
+    }
+    programs[new_program] = std::move(uniforms);
+}
+
+void uniform_cache::forget(GLuint program)
+{
+    programs.erase(program);
+}
+
+void uniform_cache::clear()
+{
+    programs.clear();
+}
+
+size_t uniform_cache::take_skipped()
+{
+    const size_t result = skipped;
+    skipped             = 0;
+    return result;
+}
+
+} // namespace my_engine
@@ -0,0 +1,174 @@
+#include "../include/vertex_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+size_t vertex_size(vertex_format format)
+{
+    switch (format)
+    {
+        case vertex_format::full:
+            return sizeof(vertex);
+        case vertex_format::half:
+            return sizeof(vertex_half);
+        case vertex_format::packed:
+            return sizeof(vertex_packed);
+    }
+    throw std::runtime_error("unknown vertex format");
+}
+
+uint16_t float_to_half(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign     = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t       mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu)
+    {
+        // inf or nan
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0));
+    }
+
+    const int half_exponent = static_cast<int>(exponent) - 127 + 15;
+    if (half_exponent >= 0x1f)
+    {
+        // too big, inf
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (half_exponent <= 0)
+    {
+        if (half_exponent < -10)
+        {
+            // too small even for denormal
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - half_exponent);
+        uint32_t       half  = mantissa >> shift;
+        // round to nearest even
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t mid  = 1u << (shift - 1);
+        if (rest > mid || (rest == mid && (half & 1u)))
+        {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = sign | (static_cast<uint32_t>(half_exponent) << 10) |
+                    (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+    {
+        // carry may go into exponent, that is still correct rounding
+        ++half;
+    }
+    return static_cast<uint16_t>(half);
+}
+
+static uint8_t to_unorm8(float value)
+{
+    return static_cast<uint8_t>(
+        std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+static uint32_t to_snorm10(float value)
+{
+    const long snorm = std::lround(value * 511.f);
+    return static_cast<uint32_t>(snorm) & 0x3ffu;
+}
+
+vertex_half to_half(const vertex& v)
+{
+    vertex_half result;
+    result.x = float_to_half(v.x);
+    result.y = float_to_half(v.y);
+    result.z = float_to_half(v.z);
+    result.w = float_to_half(1.f);
+    result.r = to_unorm8(v.r);
+    result.g = to_unorm8(v.g);
+    result.b = to_unorm8(v.b);
+    return result;
+}
+
+vertex_packed to_packed(const vertex& v)
+{
+    for (float coordinate : { v.x, v.y, v.z })
+    {
+        if (coordinate < -1.f || coordinate > 1.f)
+        {
+            throw std::runtime_error(
+                "vertex position out of [-1, 1] for packed format");
+        }
+    }
+
+    vertex_packed result;
+    result.position =
+        to_snorm10(v.x) | (to_snorm10(v.y) << 10) | (to_snorm10(v.z) << 20);
+    result.r = to_unorm8(v.r);
+    result.g = to_unorm8(v.g);
+    result.b = to_unorm8(v.b);
+    return result;
+}
+
+vertex_format fit_format(const std::vector<vertex>& vertexes,
+                         vertex_format              format)
+{
+    if (format != vertex_format::packed)
+    {
+        return format;
+    }
+    const auto outside = [](const vertex& v) {
+        return std::abs(v.x) > 1.f || std::abs(v.y) > 1.f ||
+               std::abs(v.z) > 1.f;
+    };
+    if (std::none_of(vertexes.begin(), vertexes.end(), outside))
+    {
+        return format;
+    }
+    std::clog << "note: positions out of [-1, 1], half format used instead "
+                 "of packed"
+              << std::endl;
+    return vertex_format::half;
+}
+
+std::vector<unsigned char> convert_vertexes(const std::vector<vertex>& vertexes,
+                                            vertex_format              format)
+{
+    std::vector<unsigned char> result(vertexes.size() * vertex_size(format));
+    unsigned char*             out = result.data();
+    for (const vertex& v : vertexes)
+    {
+        switch (format)
+        {
+            case vertex_format::full:
+                std::memcpy(out, &v, sizeof(v));
+                break;
+            case vertex_format::half:
+            {
+                const vertex_half h = to_half(v);
+                std::memcpy(out, &h, sizeof(h));
+                break;
+            }
+            case vertex_format::packed:
+            {
+                const vertex_packed p = to_packed(v);
+                std::memcpy(out, &p, sizeof(p));
+                break;
+            }
+        }
+        out += vertex_size(format);
+    }
+    return result;
+}
+
+} // namespace my_engine
@@ -0,0 +1,64 @@
+#include "../include/vertex_layout.hpp"
+#include "../include/shader.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace my_engine
+{
+
+const vertex_layout_desc& layout_of(vertex_format format)
+{
+    static constexpr vertex_layout_desc full   = describe_layout<vertex>();
+    static constexpr vertex_layout_desc half   = describe_layout<vertex_half>();
+    static constexpr vertex_layout_desc packed = describe_layout<vertex_packed>();
+    switch (format)
+    {
+        case vertex_format::full:
+            return full;
+        case vertex_format::half:
+            return half;
+        case vertex_format::packed:
+            return packed;
+    }
+    throw std::runtime_error("unknown vertex format");
+}
+
+void apply_vertex_layout(const vertex_layout_desc& layout,
+                         GLintptr                  base,
+                         GLuint                    divisor)
+{
+    for (size_t i = 0; i < layout.count; ++i)
+    {
+        const vertex_attribute& a = layout.attributes[i];
+        glEnableVertexAttribArray(a.location);
+        OM_GL_CHECK()
+        glVertexAttribPointer(a.location,
+                              a.count,
+                              a.type,
+                              a.normalized,
+                              layout.stride,
+                              reinterpret_cast<void*>(
+                                  base + static_cast<GLintptr>(a.offset)));
+        OM_GL_CHECK()
+        glVertexAttribDivisor(a.location, divisor);
+        OM_GL_CHECK()
+    }
+}
+
+void apply_vertex_format(const vertex_layout_desc& layout, GLuint binding)
+{
+    for (size_t i = 0; i < layout.count; ++i)
+    {
+        const vertex_attribute& a = layout.attributes[i];
+        glEnableVertexAttribArray(a.location);
+        OM_GL_CHECK()
+        glVertexAttribFormat(
+            a.location, a.count, a.type, a.normalized, a.offset);
+        OM_GL_CHECK()
+        glVertexAttribBinding(a.location, binding);
+        OM_GL_CHECK()
+    }
+}
+
+} // namespace my_engine